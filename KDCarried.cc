@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDCarried.hh"
+#include "KDProfile.hh"
 
 KDCarried::KDCarried (const String& _name, const Object& _host)
 	: Script (_name, _host),
@@ -36,13 +37,28 @@ KDCarried::KDCarried (const String& _name, const Object& _host)
 	listen_message ("FixPhysics", &KDCarried::on_fix_physics);
 }
 
+void
+KDCarried::initialize ()
+{
+	Script::initialize ();
+	KDHandles::attach ();
+}
+
+void
+KDCarried::deinitialize ()
+{
+	KDHandles::detach ();
+	Script::deinitialize ();
+}
+
 Message::Result
-KDCarried::on_post_sim (Message&)
+KDCarried::on_post_sim (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Add the FrobInert metaproperty, if requested.
 	if (inert_until_dropped)
 	{
-		host ().add_metaprop (Object ("FrobInert"));
+		host ().add_metaprop (KDHandles::get_object ("FrobInert"));
 
 		// Decrease the pickable pocket count if Contains-linked.
 		ContainsLink container = Link::get_one ("~Contains", host ());
@@ -62,8 +78,9 @@ KDCarried::on_post_sim (Message&)
 }
 
 Message::Result
-KDCarried::on_create (Message&)
+KDCarried::on_create (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Only proceed for objects created in-game.
 	if (Engine::get_mode () != Engine::Mode::GAME)
 		return Message::HALT;
@@ -74,7 +91,7 @@ KDCarried::on_create (Message&)
 
 	// Add the FrobInert metaproperty, if requested.
 	if (inert_until_dropped)
-		host ().add_metaprop (Object ("FrobInert"));
+		host ().add_metaprop (KDHandles::get_object ("FrobInert"));
 
 	return Message::HALT;
 }
@@ -82,6 +99,7 @@ KDCarried::on_create (Message&)
 Message::Result
 KDCarried::on_carrier_alerted (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	AI::Alert new_alert = message.get_data (Message::DATA1, AI::Alert::NONE);
 	if (drop_on_alert > AI::Alert::NONE && drop_on_alert <= new_alert)
 		return on_drop (message);
@@ -90,8 +108,9 @@ KDCarried::on_carrier_alerted (Message& message)
 }
 
 Message::Result
-KDCarried::on_drop (Message&)
+KDCarried::on_drop (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Physical dropped = host ();
 	was_dropped = true;
 
@@ -100,7 +119,7 @@ KDCarried::on_drop (Message&)
 
 	// Remove the FrobInert metaproperty, if requested.
 	if (inert_until_dropped)
-		dropped.remove_metaprop (Object ("FrobInert"));
+		dropped.remove_metaprop (KDHandles::get_object ("FrobInert"));
 
 	// Turn off the object and ControlDevice-linked objects, if requested.
 	if (off_when_dropped)
@@ -151,7 +170,8 @@ KDCarried::on_drop (Message&)
 
 		// Remove the clone's FrobInert if requested. Yes, again.
 		if (inert_until_dropped)
-			dropped.remove_metaprop (Object ("FrobInert"));
+			dropped.remove_metaprop
+				(KDHandles::get_object ("FrobInert"));
 	}
 
 	// Ensure that the object is physical.
@@ -174,8 +194,9 @@ KDCarried::on_drop (Message&)
 }
 
 Message::Result
-KDCarried::on_fix_physics (Message&)
+KDCarried::on_fix_physics (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Get the object dimensions based on the temporary OBB model.
 	Vector dims = host_as<OBBPhysical> ().physics_size;
 	float radius = std::max ({ dims.x, dims.y, dims.z }) / 2.0f;
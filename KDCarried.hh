@@ -21,8 +21,7 @@
 #ifndef KDCARRIED_HH
 #define KDCARRIED_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHandles.hh"
 
 class KDCarried : public Script
 {
@@ -30,6 +29,9 @@ public:
 	KDCarried (const String& name, const Object& host);
 
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
 	Message::Result on_post_sim (Message&);
 	Message::Result on_create (Message&);
 
@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDCarrier.hh"
+#include "KDProfile.hh"
 
 KDCarrier::KDCarrier (const String& _name, const Object& _host)
 	: Script (_name, _host),
@@ -59,14 +60,16 @@ KDCarrier::deinitialize ()
 Message::Result
 KDCarrier::on_sim (SimMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.event == SimMessage::START)
 		do_create_attachments ();
 	return Message::HALT;
 }
 
 Message::Result
-KDCarrier::on_create (Message&)
+KDCarrier::on_create (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	do_create_attachments ();
 	return Message::HALT;
 }
@@ -101,6 +104,7 @@ KDCarrier::do_create_attachments ()
 Message::Result
 KDCarrier::on_ai_mode_change (AIModeMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.new_mode == AI::Mode::DEAD) // killed or knocked out
 	{
 		if (detected_braindeath) // The message has already been sent.
@@ -112,8 +116,9 @@ KDCarrier::on_ai_mode_change (AIModeMessage& message)
 }
 
 Message::Result
-KDCarrier::on_ignore_potion (Message&)
+KDCarrier::on_ignore_potion (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// The AI is being knocked out.
 	detected_braindeath = true;
 	notify_carried ("CarrierBrainDead", true);
@@ -123,8 +128,9 @@ KDCarrier::on_ignore_potion (Message&)
 
 
 Message::Result
-KDCarrier::on_slain (SlayMessage&)
+KDCarrier::on_slain (SlayMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (detected_slaying) // The message has already been sent.
 		detected_slaying = false;
 	else
@@ -135,7 +141,8 @@ KDCarrier::on_slain (SlayMessage&)
 Message::Result
 KDCarrier::on_property_change (PropertyMessage& message)
 {
-	if (message.property == Property ("DeathStage") &&
+	KD_PROFILE_MESSAGE (message);
+	if (message.property == KDHandles::get_property ("DeathStage") &&
 	    host_as<Damageable> ().death_stage == 12) // The AI is being slain.
 	{
 		detected_slaying = true;
@@ -149,6 +156,7 @@ KDCarrier::on_property_change (PropertyMessage& message)
 Message::Result
 KDCarrier::on_alertness (AIAlertnessMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.new_level > AI::Alert::NONE)
 		notify_carried ("CarrierAlerted", false,
 			int (message.new_level));
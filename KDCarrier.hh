@@ -21,8 +21,7 @@
 #ifndef KDCARRIER_HH
 #define KDCARRIER_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHandles.hh"
 
 class KDCarrier : public Script
 {
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *  KDEnvScheduler.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDEnvScheduler.hh"
+
+KDEnvScheduler::Claims
+KDEnvScheduler::claims;
+
+size_t
+KDEnvScheduler::users = 0u;
+
+bool
+KDEnvScheduler::hold (Target target, const Object& owner, Time _started)
+{
+	unsigned long started = static_cast<unsigned long> (_started);
+
+	auto claim = claims.find (target);
+	if (claim == claims.end ())
+	{
+		claims [target] = { owner.number, started };
+		return true;
+	}
+
+	// A later start takes over the target. On a tie, the holder keeps it.
+	if (started > claim->second.started ||
+	    (started == claim->second.started &&
+	     owner.number == claim->second.owner))
+	{
+		claim->second = { owner.number, started };
+		return true;
+	}
+
+	return false;
+}
+
+void
+KDEnvScheduler::release (Target target, const Object& owner)
+{
+	auto claim = claims.find (target);
+	if (claim != claims.end () && claim->second.owner == owner.number)
+		claims.erase (claim);
+}
+
+size_t
+KDEnvScheduler::count_active ()
+{
+	return claims.size ();
+}
+
+void
+KDEnvScheduler::attach ()
+{
+	++users;
+}
+
+void
+KDEnvScheduler::detach ()
+{
+	if (users > 0u && --users == 0u)
+		claims.clear ();
+}
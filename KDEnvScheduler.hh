@@ -0,0 +1,62 @@
+/******************************************************************************
+ *  KDEnvScheduler.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDENVSCHEDULER_HH
+#define KDENVSCHEDULER_HH
+
+#include <Thief/Thief.hh>
+#include <map>
+using namespace Thief;
+
+// Arbitrates between the environment transitions of all scripts in the
+// module. A target (a fog zone, by number) is written by only one transition
+// at a time: the one started last. When a transition starts, any older one on
+// the same target loses its claim, and should stop at its next step. This
+// only keeps the claims; each script still steps its own transition.
+//
+// Scripts using the claims attach on initialize and detach on deinitialize.
+// The claims are dropped when the last one detaches, as happens when a game
+// is loaded or the mission ends. Since the start times are kept by the
+// scripts, the claims are rebuilt correctly as the transitions resume.
+class KDEnvScheduler
+{
+public:
+	typedef int Target;
+
+	static bool hold (Target target, const Object& owner, Time started);
+	static void release (Target target, const Object& owner);
+	static size_t count_active ();
+
+	static void attach ();
+	static void detach ();
+
+private:
+	struct Claim
+	{
+		Object::Number owner;
+		unsigned long started;
+	};
+
+	typedef std::map<Target, Claim> Claims;
+	static Claims claims;
+	static size_t users;
+};
+
+#endif // KDENVSCHEDULER_HH
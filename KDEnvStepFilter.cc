@@ -0,0 +1,93 @@
+/******************************************************************************
+ *  KDEnvStepFilter.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDEnvStepFilter.hh"
+
+KDEnvStepFilter::KDEnvStepFilter (const Object& host)
+	: min_interval (host, "transition_step_min", 50ul),
+	  max_interval (host, "transition_step_max", 1000ul),
+	  written (false),
+	  last_write (0ul)
+{}
+
+void
+KDEnvStepFilter::reset ()
+{
+	written = false;
+	last_write = 0ul;
+}
+
+bool
+KDEnvStepFilter::admit (Transition& transition, float change)
+{
+	float progress = transition.get_progress ();
+	return admit (std::lround (progress * static_cast<unsigned long>
+		(Time (transition.length))), change, progress >= 1.0f);
+}
+
+bool
+KDEnvStepFilter::admit (unsigned long now, float change, bool last)
+{
+	bool write = !written || last;
+	if (!write && now >= last_write + static_cast<unsigned long>
+			(Time (min_interval)))
+		write = change >= 1.0f || now >= last_write +
+			static_cast<unsigned long> (Time (max_interval));
+
+	if (write)
+	{
+		written = true;
+		last_write = now;
+	}
+	return write;
+}
+
+// Returns the change from a to b relative to the larger of the two, scaled
+// so that a difference of the given fraction of that is 1.0.
+static float
+relative_change (float a, float b, float fraction)
+{
+	float scale = std::max ({ std::fabs (a), std::fabs (b), 1.0f });
+	return std::fabs (b - a) / scale / fraction;
+}
+
+float
+KDEnvStepFilter::get_change (const Fog& from, const Fog& to)
+{
+	// Colors are already quantized to visible steps, so any difference
+	// there counts as noticeable.
+	if (from.color != to.color)
+		return 1.0f;
+	return relative_change (from.distance, to.distance, 0.01f);
+}
+
+float
+KDEnvStepFilter::get_change (const Precipitation& from,
+	const Precipitation& to)
+{
+	return std::max ({
+		relative_change (from.frequency, to.frequency, 0.02f),
+		relative_change (from.speed, to.speed, 0.02f),
+		relative_change (from.radius, to.radius, 0.02f),
+		std::fabs (to.opacity - from.opacity) / 0.01f,
+		std::fabs (to.brightness - from.brightness) / 0.01f,
+		from.wind.distance (to.wind) / 0.1f
+	});
+}
@@ -0,0 +1,52 @@
+/******************************************************************************
+ *  KDEnvStepFilter.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDENVSTEPFILTER_HH
+#define KDENVSTEPFILTER_HH
+
+#include <Thief/Thief.hh>
+using namespace Thief;
+
+// Decides which steps of a fog or weather transition are passed on to the
+// engine. A step is written once its value has changed noticeably since the
+// last write, but no sooner than transition_step_min and no later than
+// transition_step_max after it. The effective rate therefore follows the
+// length and size of the change. The first and last steps are always written.
+class KDEnvStepFilter
+{
+public:
+	KDEnvStepFilter (const Object& host);
+
+	void reset ();
+	bool admit (Transition& transition, float change);
+	bool admit (unsigned long now, float change, bool last = false);
+
+	// These return 1.0 or more for a noticeable change.
+	static float get_change (const Fog& from, const Fog& to);
+	static float get_change (const Precipitation& from,
+		const Precipitation& to);
+
+private:
+	Parameter<Time> min_interval, max_interval;
+	bool written;
+	unsigned long last_write;
+};
+
+#endif // KDENVSTEPFILTER_HH
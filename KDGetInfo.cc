@@ -19,19 +19,101 @@
  *****************************************************************************/
 
 #include "KDGetInfo.hh"
+#include "KDEnvScheduler.hh"
+#include "KDProfile.hh"
+#include "KDWeatherStack.hh"
+
+const HUDElement::ZIndex
+KDGetInfo::PRIORITY = 0;
+
+const size_t
+KDGetInfo::PROFILE_SITES = 10u;
 
 KDGetInfo::KDGetInfo (const String& _name, const Object& _host)
-	: Script (_name, _host)
+	: Script (_name, _host),
+	  KDHUDElement (PRIORITY),
+	  THIEF_PARAMETER_FULL (perf, "info_perf", false),
+	  THIEF_PARAMETER_FULL (profile, "info_profile", false),
+	  THIEF_PARAMETER_FULL (record, "info_record", false),
+	  THIEF_PARAMETER_FULL (perf_period, "info_perf_period", 1000ul),
+	  THIEF_PERSISTENT_FULL (perf_updates, 0),
+	  counting (false),
+	  frames (0u)
 {
 	listen_message ("BeginScript", &KDGetInfo::on_begin_script);
 	listen_message ("DarkGameModeChange", &KDGetInfo::on_mode_change);
 	listen_message ("UpdateVariables", &KDGetInfo::on_update_variables);
 	listen_message ("EndScript", &KDGetInfo::on_end_script);
+	listen_timer ("UpdatePerformance", &KDGetInfo::on_update_performance);
+}
+
+void
+KDGetInfo::initialize ()
+{
+	Script::initialize ();
+
+	// A game may have been loaded with other values saved in it.
+	variables.clear ();
+
+	// The performance variables and the script profile are only measured
+	// on request.
+	counting = perf || profile;
+	KDProfile::set_enabled (profile);
+
+	// A recording grows its file with each session, so a mission can only
+	// ask for one in the editor. In the game, the player must set
+	// kdscript_record in the configuration. A game may have been loaded,
+	// so start a new session.
+	if ((Engine::is_editor () && record) ||
+	    Engine::has_config ("kdscript_record"))
+	{
+		if (KDProfile::start_recording ())
+			log (Log::NORMAL, "Recording script messages to %||.",
+				KDProfile::RECORDING_FILE);
+		else
+			log (Log::ERROR, "Can't record script messages to %||.",
+				KDProfile::RECORDING_FILE);
+	}
+
+	if (counting)
+	{
+		KDHUDElement::initialize ();
+		frames = 0u;
+		period_start = Clock::now ();
+
+		// Any timer restored from a saved game is superseded.
+		perf_updates = perf_updates + 1;
+		start_timer ("UpdatePerformance", perf_period, false,
+			int (perf_updates));
+	}
+}
+
+void
+KDGetInfo::deinitialize ()
+{
+	if (counting)
+		KDHUDElement::deinitialize ();
+	counting = false;
+	KDProfile::set_enabled (false);
+	KDProfile::stop_recording ();
+	Script::deinitialize ();
+}
+
+bool
+KDGetInfo::prepare_element ()
+{
+	++frames;
+	return false;
 }
 
+void
+KDGetInfo::redraw_element ()
+{}
+
 Message::Result
-KDGetInfo::on_begin_script (Message&)
+KDGetInfo::on_begin_script (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Some settings aren't available yet, so wait for next message cycle.
 	GenericMessage ("UpdateVariables").post (host (), host ());
 	return Message::HALT;
@@ -40,56 +122,66 @@ KDGetInfo::on_begin_script (Message&)
 Message::Result
 KDGetInfo::on_mode_change (GameModeMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.event == GameModeMessage::RESUME)
 		GenericMessage ("UpdateVariables").send (host (), host ());
 	return Message::HALT;
 }
 
 Message::Result
-KDGetInfo::on_update_variables (Message&)
+KDGetInfo::on_update_variables (Message& message)
 {
-	QuestVar ("info_directx_version") = Engine::get_directx_version ();
+	KD_PROFILE_MESSAGE (message);
+	set_variable ("info_directx_version", Engine::get_directx_version ());
 
 	CanvasSize canvas = Engine::get_canvas_size ();
-	QuestVar ("info_display_height") = canvas.h;
-	QuestVar ("info_display_width") = canvas.w;
+	set_variable ("info_display_height", canvas.h);
+	set_variable ("info_display_width", canvas.w);
 
 	if (Engine::has_config ("sfx_eax"))
-		QuestVar ("info_has_eax") = Engine::get_config<int> ("sfx_eax");
+		set_variable ("info_has_eax",
+			Engine::get_config<int> ("sfx_eax"));
 
 	if (Engine::has_config ("fogging"))
-		QuestVar ("info_has_fog") = Engine::get_config<int> ("fogging");
+		set_variable ("info_has_fog",
+			Engine::get_config<int> ("fogging"));
 
 	if (Engine::has_config ("game_hardware"))
-		QuestVar ("info_has_hw3d") =
-			Engine::get_config<int> ("game_hardware");
+		set_variable ("info_has_hw3d",
+			Engine::get_config<int> ("game_hardware"));
 
 	if (Engine::has_config ("enhanced_sky"))
-		QuestVar ("info_has_sky") =
-			Engine::get_config<int> ("enhanced_sky");
+		set_variable ("info_has_sky",
+			Engine::get_config<int> ("enhanced_sky"));
 
 	if (Engine::has_config ("render_weather"))
-		QuestVar ("info_has_weather") =
-			Engine::get_config<int> ("render_weather");
+		set_variable ("info_has_weather",
+			Engine::get_config<int> ("render_weather"));
 
 #ifdef IS_THIEF2
 	if (Engine::get_mode () == Engine::Mode::GAME)
-		QuestVar ("info_mission") = Mission::get_number ();
+		set_variable ("info_mission", Mission::get_number ());
 #endif // IS_THIEF2
 
-	QuestVar ("info_mode") = (Engine::get_mode () == Engine::Mode::EDIT)
-		? 1 : Engine::is_editor () ? 2 : 0;
+	set_variable ("info_mode", (Engine::get_mode () == Engine::Mode::EDIT)
+		? 1 : Engine::is_editor () ? 2 : 0);
 
 	Version version = Engine::get_version ();
-	QuestVar ("info_version_major") = version.major;
-	QuestVar ("info_version_minor") = version.minor;
+	set_variable ("info_version_major", version.major);
+	set_variable ("info_version_minor", version.minor);
 
 	return Message::HALT;
 }
 
 Message::Result
-KDGetInfo::on_end_script (Message&)
+KDGetInfo::on_end_script (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
+	// Report whatever was measured since the last period.
+	if (counting)
+		update_performance ();
+	KDProfile::stop_recording ();
+
 	QuestVar ("info_directx_version").clear ();
 	QuestVar ("info_display_height").clear ();
 	QuestVar ("info_display_width").clear ();
@@ -102,6 +194,108 @@ KDGetInfo::on_end_script (Message&)
 	QuestVar ("info_mode").clear ();
 	QuestVar ("info_version_major").clear ();
 	QuestVar ("info_version_minor").clear ();
+	QuestVar ("info_perf_fps").clear ();
+	QuestVar ("info_perf_frame_time").clear ();
+	QuestVar ("info_perf_hud_elements").clear ();
+	QuestVar ("info_perf_env_blends").clear ();
+	QuestVar ("info_profile_calls").clear ();
+	QuestVar ("info_profile_time").clear ();
+	variables.clear ();
 	return Message::HALT;
 }
 
+Message::Result
+KDGetInfo::on_update_performance (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (!counting || message.get_data (Message::DATA1, 0) != perf_updates)
+		return Message::HALT;
+
+	update_performance ();
+	start_timer ("UpdatePerformance", perf_period, false,
+		int (perf_updates));
+	return Message::HALT;
+}
+
+void
+KDGetInfo::set_variable (const char* name, int value)
+{
+	auto known = variables.find (name);
+	if (known != variables.end () && known->second == value)
+		return;
+	variables [name] = value;
+	QuestVar (name) = value;
+}
+
+void
+KDGetInfo::update_performance ()
+{
+	Clock::time_point now = Clock::now ();
+	long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+		(now - period_start).count ();
+
+	if (perf && frames > 0u && elapsed > 0l)
+	{
+		set_variable ("info_perf_fps",
+			int (std::lround (frames * 1000.0 / elapsed)));
+		set_variable ("info_perf_frame_time",
+			int (std::lround (double (elapsed) / frames)));
+
+		// This element is not counted, as it is never drawn.
+		set_variable ("info_perf_hud_elements",
+			int (KDHUDElement::count_elements ()) - 1);
+
+		// Environment targets being changed by a transition, and
+		// weather layers still being blended in.
+		set_variable ("info_perf_env_blends",
+			int (KDEnvScheduler::count_active () +
+				KDWeatherStack::count_blending ()));
+	}
+
+	if (profile)
+		report_profile (elapsed);
+
+	frames = 0u;
+	period_start = now;
+}
+
+static long
+to_microseconds (KDProfile::Clock::duration time)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>
+		(time).count ();
+}
+
+void
+KDGetInfo::report_profile (long elapsed)
+{
+	std::vector<KDProfile::Report> reports = KDProfile::collect ();
+	unsigned long calls = 0ul;
+	KDProfile::Clock::duration total = KDProfile::Clock::duration::zero ();
+	for (auto& report : reports)
+	{
+		calls += report.timing.calls;
+		total += report.timing.total;
+	}
+
+	if (calls > 0ul)
+	{
+		log (Log::NORMAL, "Scripts took %|| us in %|| calls over the "
+			"last %|| ms. The busiest were:",
+			to_microseconds (total), calls, elapsed);
+		for (size_t index = 0u;
+		     index < reports.size () && index < PROFILE_SITES; ++index)
+		{
+			auto& timing = reports [index].timing;
+			log (Log::NORMAL, "    %||: %|| calls, %|| us total, "
+				"%|| us longest", reports [index].name,
+				timing.calls, to_microseconds (timing.total),
+				to_microseconds (timing.longest));
+		}
+	}
+
+	set_variable ("info_profile_calls", int (calls));
+	set_variable ("info_profile_time", int (to_microseconds (total)));
+	KDProfile::reset ();
+}
+
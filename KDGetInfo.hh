@@ -21,19 +21,49 @@
 #ifndef KDGETINFO_HH
 #define KDGETINFO_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHUDElement.hh"
+#include <chrono>
+#include <map>
 
-class KDGetInfo : public Script
+class KDGetInfo : public Script, public KDHUDElement
 {
 public:
 	KDGetInfo (const String& name, const Object& host);
 
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
+	// The element is never drawn. It only counts frames for the live
+	// performance variables, which are published from a timer.
+	virtual bool prepare_element ();
+	virtual void redraw_element ();
+
 	Message::Result on_begin_script (Message&);
 	Message::Result on_mode_change (GameModeMessage&);
 	Message::Result on_update_variables (Message&);
 	Message::Result on_end_script (Message&);
+	Message::Result on_update_performance (TimerMessage&);
+
+	// Only a changed value is written, so that subscribers aren't woken
+	// early. The values written are kept here to compare against.
+	void set_variable (const char* name, int value);
+	std::map<String, int> variables;
+
+	void update_performance ();
+	void report_profile (long elapsed);
+
+	static const ZIndex PRIORITY;
+	static const size_t PROFILE_SITES;
+
+	Parameter<bool> perf, profile, record;
+	Parameter<Time> perf_period;
+	Persistent<int> perf_updates;
+
+	typedef std::chrono::steady_clock Clock;
+	bool counting;
+	unsigned frames;
+	Clock::time_point period_start;
 };
 
 #endif // KDGETINFO_HH
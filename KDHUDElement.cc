@@ -19,6 +19,9 @@
  *****************************************************************************/
 
 #include "KDHUDElement.hh"
+#include <cxxabi.h>
+#include <cstdlib>
+#include <typeinfo>
 
 
 
@@ -49,19 +52,55 @@ THIEF_ENUM_CODING (KDHUDElement::Symbol, CODE, CODE,
 
 
 KDHUDElement::KDHUDElement (ZIndex _priority)
-	: priority (_priority)
+	: priority (_priority),
+	  prepare_site (nullptr),
+	  redraw_site (nullptr)
 {}
 
 void
 KDHUDElement::initialize ()
 {
+	// The derived class is complete by now, so its name can be found.
+	const char* type = typeid (*this).name ();
+	int status = 0;
+	char* demangled = abi::__cxa_demangle (type, nullptr, nullptr, &status);
+	String element = (status == 0 && demangled) ? demangled : type;
+	std::free (demangled);
+	prepare_site = &KDProfile::get_site (element + "::prepare");
+	redraw_site = &KDProfile::get_site (element + "::redraw");
+
 	HUDElement::initialize (priority);
+	++elements;
 }
 
 void
 KDHUDElement::deinitialize ()
 {
 	HUDElement::deinitialize ();
+	if (elements > 0u) --elements;
+}
+
+bool
+KDHUDElement::prepare ()
+{
+	KDProfile::Guard guard (*prepare_site);
+	return prepare_element ();
+}
+
+void
+KDHUDElement::redraw ()
+{
+	KDProfile::Guard guard (*redraw_site);
+	redraw_element ();
+}
+
+size_t
+KDHUDElement::elements = 0u;
+
+size_t
+KDHUDElement::count_elements ()
+{
+	return elements;
 }
 
 
@@ -21,8 +21,7 @@
 #ifndef KDHUDELEMENT_HH
 #define KDHUDELEMENT_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDProfile.hh"
 
 class KDHUDElement : public HUDElement
 {
@@ -58,6 +57,8 @@ public:
 		HUDBitmap::Ptr bitmap;
 	};
 
+	static size_t count_elements ();
+
 protected:
 	KDHUDElement (ZIndex priority);
 
@@ -83,7 +84,17 @@ protected:
 		Direction direction = Direction::NONE) const;
 
 private:
+	// The prepare and redraw of each element are timed here, under the
+	// element's class name, and passed on to these.
+	virtual bool prepare ();
+	virtual void redraw ();
+	virtual bool prepare_element () = 0;
+	virtual void redraw_element () = 0;
+
 	ZIndex priority;
+	static size_t elements;
+	KDProfile::Site* prepare_site;
+	KDProfile::Site* redraw_site;
 };
 
 namespace Thief {
@@ -0,0 +1,63 @@
+/******************************************************************************
+ *  KDHandles.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDHandles.hh"
+
+KDHandles::Objects
+KDHandles::objects;
+
+KDHandles::Properties
+KDHandles::properties;
+
+size_t
+KDHandles::users = 0u;
+
+Object
+KDHandles::get_object (const char* name)
+{
+	auto object = objects.find (name);
+	if (object == objects.end ())
+		object = objects.insert (std::make_pair (name, Object (name)))
+			.first;
+	return object->second;
+}
+
+Property
+KDHandles::get_property (const char* name)
+{
+	auto property = properties.find (name);
+	if (property == properties.end ())
+		property = properties.insert
+			(std::make_pair (name, Property (name))).first;
+	return property->second;
+}
+
+void
+KDHandles::attach ()
+{
+	++users;
+}
+
+void
+KDHandles::detach ()
+{
+	if (users > 0u && --users == 0u)
+		objects.clear ();
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+ *  KDHandles.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDHANDLES_HH
+#define KDHANDLES_HH
+
+#include <Thief/Thief.hh>
+#include <map>
+using namespace Thief;
+
+// Keeps the engine handles for objects and properties that the scripts refer
+// to by name, so that each name is only looked up once. Names are compared
+// without regard to case, as the engine does. Properties are the same for the
+// whole game, but object numbers can differ between missions. Any script that
+// gets objects here must attach on initialize and detach on deinitialize. The
+// objects are forgotten when the last such script detaches, as happens when a
+// game is loaded or the mission ends.
+class KDHandles
+{
+public:
+	static Object get_object (const char* name);
+	static Property get_property (const char* name);
+
+	static void attach ();
+	static void detach ();
+
+private:
+	typedef std::map<CIString, Object> Objects;
+	static Objects objects;
+
+	typedef std::map<CIString, Property> Properties;
+	static Properties properties;
+
+	static size_t users;
+};
+
+#endif // KDHANDLES_HH
@@ -19,6 +19,8 @@
  *****************************************************************************/
 
 #include "KDJunkTool.hh"
+#include "KDProfile.hh"
+#include "KDTimerWheel.hh"
 
 
 
@@ -26,7 +28,8 @@ KDJunkTool::KDJunkTool (const String& _name, const Object& _host)
 	: Script (_name, _host),
 	  THIEF_PARAMETER_FULL (lugged, "junk_tool_lugged", true),
 	  THIEF_PARAMETER_FULL (drop, "junk_tool_drop", false),
-	  THIEF_PERSISTENT_FULL (previous_weapon, Object::NONE)
+	  THIEF_PERSISTENT_FULL (previous_weapon, Object::NONE),
+	  THIEF_PERSISTENT_FULL (frobbable_shows, 0)
 {
 	listen_message ("Contained", &KDJunkTool::on_contained);
 	listen_message ("Destroy", &KDJunkTool::on_destroy);
@@ -37,6 +40,7 @@ KDJunkTool::KDJunkTool (const String& _name, const Object& _host)
 	listen_message ("FrobInvEnd", &KDJunkTool::on_needs_reselect);
 	listen_message ("FrobToolEnd", &KDJunkTool::on_needs_reselect);
 	listen_message ("Reselect", &KDJunkTool::on_reselect);
+	listen_timer ("HideFrobbable", &KDJunkTool::on_hide_frobbable);
 
 	listen_message ("InvDeFocus", &KDJunkTool::on_needs_tool_use);
 	listen_timer ("StartToolUse", &KDJunkTool::on_start_tool_use);
@@ -44,12 +48,27 @@ KDJunkTool::KDJunkTool (const String& _name, const Object& _host)
 	listen_message ("Slain", &KDJunkTool::on_slain);
 }
 
+void
+KDJunkTool::initialize ()
+{
+	Script::initialize ();
+	KDHandles::attach ();
+}
+
+void
+KDJunkTool::deinitialize ()
+{
+	KDHandles::detach ();
+	Script::deinitialize ();
+}
+
 
 
 Message::Result
 KDJunkTool::on_contained (ContainmentMessage& message)
 {
-	if (message.container.inherits_from (Object ("Avatar")))
+	KD_PROFILE_MESSAGE (message);
+	if (message.container.inherits_from (KDHandles::get_object ("Avatar")))
 		switch (message.event)
 		{
 		case ContainmentMessage::ADD: start_carry (); break;
@@ -60,8 +79,9 @@ KDJunkTool::on_contained (ContainmentMessage& message)
 }
 
 Message::Result
-KDJunkTool::on_destroy (Message&)
+KDJunkTool::on_destroy (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (Player ().is_in_inventory (host ()))
 		finish_carry ();
 	return Message::HALT;
@@ -73,8 +93,10 @@ KDJunkTool::start_carry ()
 	Player player;
 	if (!player.is_in_inventory (host ())) return;
 
-	// Keep clearing any weapon while the tool is in inventory.
-	start_timer ("ClearWeapon", 1, false);
+	// Keep clearing any weapon while the tool is in inventory. The phase
+	// offset keeps several carried tools from polling in the same frame.
+	start_timer ("ClearWeapon",
+		1ul + KDTimerWheel::get_phase (host (), 100ul), false);
 
 	// If lugged: slow down the player, show limb model if any, and grunt.
 	if (lugged)
@@ -82,7 +104,8 @@ KDJunkTool::start_carry ()
 		player.add_speed_control ("JunkTool", 0.6f);
 		if (host_as<Interactive> ().limb_model.exists ())
 			player.show_arm ();
-		SoundSchema ("garlift").play_voiceover ();
+		SoundSchema (KDHandles::get_object ("garlift"))
+			.play_voiceover ();
 	}
 
 	// Select the tool and start tool use.
@@ -103,15 +126,25 @@ KDJunkTool::finish_carry ()
 	{
 		player.remove_speed_control ("JunkTool");
 		player.hide_arm ();
-		SoundSchema ("gardrop").play_voiceover ();
+		SoundSchema (KDHandles::get_object ("gardrop"))
+			.play_voiceover ();
 	}
 }
 
 
 
 Message::Result
-KDJunkTool::on_clear_weapon (TimerMessage&)
+KDJunkTool::on_clear_weapon (TimerMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
+
+	// If too many periodic scripts are running now, try again shortly.
+	if (!KDTimerWheel::admit (message.get_time ()))
+	{
+		start_timer ("ClearWeapon", KDTimerWheel::SLOT_LENGTH, false);
+		return Message::HALT;
+	}
+
 	Player player;
 	if (player.is_in_inventory (host ()))
 	{
@@ -129,67 +162,99 @@ KDJunkTool::on_clear_weapon (TimerMessage&)
 
 
 Message::Result
-KDJunkTool::on_needs_reselect (Message&)
+KDJunkTool::on_needs_reselect (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Reselect the tool in the next cycle (won't work in this one).
 	GenericMessage ("Reselect").post (host (), host ());
 	return Message::HALT;
 }
 
 Message::Result
-KDJunkTool::on_reselect (Message&)
+KDJunkTool::on_reselect (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Player player;
 	if (player.is_in_inventory (host ()))
 	{
 		// (Re)select the tool.
 		player.select_item (host ());
 
-		// Create a fake frobbable and schedule to start tool use.
-		create_frobbable ();
+		// Show the fake frobbable and schedule to start tool use.
+		show_frobbable ();
 		start_timer ("StartToolUse", 50, false);
 	}
 
 	return Message::HALT;
 }
 
-Object
-KDJunkTool::create_frobbable ()
+void
+KDJunkTool::show_frobbable ()
 {
 	// The command for starting tool use does not work consistently. In some
 	// cases, it does not work unless there is a frobbable item currently 
 	// focused in the world. (I can't tell why.) To make the command always
-	// be effective, this method creates a fake frobbable object in front of
-	// the player that will destroy itself instantly, temporarily creating
-	// the conditions required by the command.
+	// be effective, this method places a fake frobbable object in front of
+	// the player and hides it again shortly, temporarily creating the
+	// conditions required by the command. The same object is reused for
+	// every reselect to avoid creating and destroying objects constantly.
+	Interactive frobbable = get_frobbable ();
 
-	// Create the object and make it frobbable.
-	Interactive frobbable = Object::create_temp_fnord (100ul);
-	frobbable.frob_world_action = Interactive::FrobAction::FROB_SCRIPTS;
-
-	// Move and enlarge it to fill the player's view.
+	// Move it to fill the player's view.
 	frobbable.set_position ({ 2.0f, 0.0f, 0.0f }, Vector (), Player ());
-	frobbable.model_scale = { 10.0f, 10.0f, 20.0f };
 
 	// Make it technically, but not actually, visible.
 	frobbable.render_type = Rendered::RenderType::NORMAL;
-	frobbable.opacity = 0.01f;
 
+	// Schedule it to be hidden again, ignoring any earlier schedule.
+	frobbable_shows = frobbable_shows + 1;
+	start_timer ("HideFrobbable", 100ul, false, int (frobbable_shows));
+}
+
+Interactive
+KDJunkTool::get_frobbable ()
+{
+	Interactive frobbable ("KDJunkToolFrobbable");
+	if (!frobbable.exists ())
+	{
+		log (Log::VERBOSE, "Creating the KDJunkToolFrobbable fnord.");
+		frobbable = Object::create (Object ("Marker"));
+		frobbable.set_name ("KDJunkToolFrobbable");
+		frobbable.frob_world_action =
+			Interactive::FrobAction::FROB_SCRIPTS;
+		frobbable.model_scale = { 10.0f, 10.0f, 20.0f };
+		frobbable.opacity = 0.01f;
+		frobbable.render_type = Rendered::RenderType::NOT_RENDERED;
+	}
 	return frobbable;
 }
 
+Message::Result
+KDJunkTool::on_hide_frobbable (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (message.get_data (Message::DATA1, 0) != frobbable_shows)
+		return Message::HALT; // It was shown again since.
+
+	Interactive frobbable = get_frobbable ();
+	frobbable.render_type = Rendered::RenderType::NOT_RENDERED;
+	return Message::HALT;
+}
+
 
 
 Message::Result
-KDJunkTool::on_needs_tool_use (Message&)
+KDJunkTool::on_needs_tool_use (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	start_timer ("StartToolUse", 1, false);
 	return Message::HALT;
 }
 
 Message::Result
-KDJunkTool::on_start_tool_use (TimerMessage&)
+KDJunkTool::on_start_tool_use (TimerMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Player ().start_tool_use ();
 	return Message::HALT;
 }
@@ -197,8 +262,9 @@ KDJunkTool::on_start_tool_use (TimerMessage&)
 
 
 Message::Result
-KDJunkTool::on_slain (SlayMessage&)
+KDJunkTool::on_slain (SlayMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Player player;
 	if (drop && player.is_in_inventory (host ()))
 	{
@@ -21,8 +21,7 @@
 #ifndef KDJUNKTOOL_HH
 #define KDJUNKTOOL_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHandles.hh"
 
 class KDJunkTool : public Script
 {
@@ -30,6 +29,9 @@ public:
 	KDJunkTool (const String& name, const Object& host);
 
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
 	Message::Result on_contained (ContainmentMessage&);
 	Message::Result on_destroy (Message&);
 	void start_carry ();
@@ -39,7 +41,9 @@ private:
 
 	Message::Result on_needs_reselect (Message&);
 	Message::Result on_reselect (Message&);
-	Object create_frobbable ();
+	void show_frobbable ();
+	Interactive get_frobbable ();
+	Message::Result on_hide_frobbable (TimerMessage&);
 
 	Message::Result on_needs_tool_use (Message&);
 	Message::Result on_start_tool_use (TimerMessage&);
@@ -48,6 +52,7 @@ private:
 
 	Parameter<bool> lugged, drop;
 	Persistent<Weapon> previous_weapon;
+	Persistent<int> frobbable_shows;
 };
 
 #endif // KDJUNKTOOL_HH
@@ -19,27 +19,52 @@
  *****************************************************************************/
 
 #include "KDOptionalReverse.hh"
+#include "KDProfile.hh"
+#include <cctype>
+#include <cstdlib>
 
 KDOptionalReverse::KDOptionalReverse (const String& _name, const Object& _host)
 	: Script (_name, _host)
+#ifdef IS_THIEF2
+	  , negations_known (false)
+#endif // IS_THIEF2
 {
 	listen_message ("PostSim", &KDOptionalReverse::on_post_sim);
 #ifdef IS_THIEF2
 	listen_message ("ObjectiveChange",
 		&KDOptionalReverse::on_objective_change);
+	listen_message ("QuestChange", &KDOptionalReverse::on_quest_change);
 	listen_message ("Sim", &KDOptionalReverse::on_sim);
 #endif // IS_THIEF2
 }
 
 #ifdef IS_THIEF2
 
+const String
+KDOptionalReverse::NEGATION_PREFIX = "goal_negation_";
+
+void
+KDOptionalReverse::initialize ()
+{
+	Script::initialize ();
+
+	// A game may have been loaded, so reread the negations when needed.
+	negations_known = false;
+}
+
 Message::Result
-KDOptionalReverse::on_post_sim (Message&)
+KDOptionalReverse::on_post_sim (Message& message)
 {
-	// Subscribe to objectives with negations.
+	KD_PROFILE_MESSAGE (message);
+	// Subscribe to objectives with negations, and to the negation quest
+	// variables of all objectives in case any is set later.
+	read_negations ();
 	for (Objective objective = 0; objective.exists (); ++objective)
-		if (get_negation (objective).number != Objective::NONE)
+	{
+		QuestVar (get_negation_var (objective)).subscribe (host ());
+		if (negations.count (objective.number))
 			objective.state.subscribe (host ());
+	}
 
 	return Message::HALT;
 }
@@ -47,6 +72,7 @@ KDOptionalReverse::on_post_sim (Message&)
 Message::Result
 KDOptionalReverse::on_objective_change (ObjectiveMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.field == ObjectiveMessage::Field::STATE &&
 	    message.old_raw_value != message.new_raw_value )
 		// Translate from the objective to its negation.
@@ -55,22 +81,81 @@ KDOptionalReverse::on_objective_change (ObjectiveMessage& message)
 	return Message::HALT;
 }
 
+Message::Result
+KDOptionalReverse::on_quest_change (QuestMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (message.quest_var.compare (0u, NEGATION_PREFIX.length (),
+			NEGATION_PREFIX) != 0)
+		return Message::CONTINUE;
+
+	// The variable may belong to another script on this host, so ignore
+	// any whose name doesn't end in an objective number.
+	const char* number = message.quest_var.c_str ()
+		+ NEGATION_PREFIX.length ();
+	char* end = nullptr;
+	long parsed = std::strtol (number, &end, 10);
+	if (!std::isdigit (static_cast<unsigned char> (*number)) ||
+	    *end != '\0')
+		return Message::CONTINUE;
+
+	Objective objective = int (parsed);
+	read_negations ();
+	if (message.new_value == Objective::NONE)
+		negations.erase (objective.number);
+	else
+	{
+		negations [objective.number] = message.new_value;
+		objective.state.subscribe (host ());
+	}
+
+	return Message::HALT;
+}
+
 Message::Result
 KDOptionalReverse::on_sim (SimMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Fix anything that VictoryCheck did incorrectly.
 	if (message.event == SimMessage::FINISH)
-		for (Objective objective = 0; objective.exists (); ++objective)
-			update_negation (objective, true);
+	{
+		read_negations ();
+		for (auto& negation : negations)
+			update_negation (negation.first, true);
+	}
 
 	return Message::HALT;
 }
 
+String
+KDOptionalReverse::get_negation_var (Objective objective)
+{
+	return NEGATION_PREFIX + std::to_string (objective.number);
+}
+
+void
+KDOptionalReverse::read_negations ()
+{
+	if (negations_known) return;
+
+	negations.clear ();
+	for (Objective objective = 0; objective.exists (); ++objective)
+	{
+		Objective negation = QuestVar (get_negation_var (objective))
+			.get (Objective::NONE);
+		if (negation.number != Objective::NONE)
+			negations [objective.number] = negation.number;
+	}
+	negations_known = true;
+}
+
 Objective
 KDOptionalReverse::get_negation (Objective objective)
 {
-	return QuestVar ("goal_negation_" + std::to_string (objective.number))
-		.get (Objective::NONE);
+	read_negations ();
+	auto negation = negations.find (objective.number);
+	return (negation != negations.end ())
+		? negation->second : Objective::NONE;
 }
 
 void
@@ -108,8 +193,9 @@ KDOptionalReverse::update_negation (Objective objective, bool final)
 #else // !IS_THIEF2
 
 Message::Result
-KDOptionalReverse::on_post_sim (Message&)
+KDOptionalReverse::on_post_sim (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	log (Log::ERROR, "This script is not available for this game.");
 	return Message::ERROR;
 }
@@ -22,6 +22,7 @@
 #define KDOPTIONALREVERSE_HH
 
 #include <Thief/Thief.hh>
+#include <map>
 using namespace Thief;
 
 class KDOptionalReverse : public Script
@@ -32,11 +33,21 @@ public:
 private:
 	Message::Result on_post_sim (Message&);
 #ifdef IS_THIEF2
+	virtual void initialize ();
+
 	Message::Result on_objective_change (ObjectiveMessage&);
+	Message::Result on_quest_change (QuestMessage&);
 	Message::Result on_sim (SimMessage&);
 
+	static const String NEGATION_PREFIX;
+	static String get_negation_var (Objective objective);
+	void read_negations ();
 	Objective get_negation (Objective objective);
 	void update_negation (Objective objective, bool final);
+
+	typedef std::map<Objective::Number, Objective::Number> Negations;
+	Negations negations;
+	bool negations_known;
 #endif // IS_THIEF2
 };
 
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *  KDPackedState.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDPackedState.hh"
+
+static const char HEX_DIGITS [] = "0123456789abcdef";
+
+static int
+hex_value (char digit)
+{
+	if (digit >= '0' && digit <= '9') return digit - '0';
+	if (digit >= 'a' && digit <= 'f') return digit - 'a' + 10;
+	return -1;
+}
+
+KDPackedStateBase::KDPackedStateBase (Script& script, const String& name,
+		unsigned _version)
+	: blob (script, name),
+	  version (_version & 0xffu)
+{}
+
+bool
+KDPackedStateBase::exists () const
+{
+	return blob.exists ();
+}
+
+void
+KDPackedStateBase::remove ()
+{
+	blob.remove ();
+	raw.clear ();
+	bytes.clear ();
+}
+
+const void*
+KDPackedStateBase::load (size_t size) const
+{
+	if (!blob.exists ()) return nullptr;
+
+	const String& current = blob;
+	if (current != raw)
+	{
+		raw = current;
+		bytes.clear ();
+
+		// The record is the version, then the state, each byte in two
+		// hex digits. Anything else is ignored.
+		if (raw.size () != 2u * (size + 1u) ||
+		    raw [0] != HEX_DIGITS [version >> 4] ||
+		    raw [1] != HEX_DIGITS [version & 0xfu])
+			return nullptr;
+
+		bytes.reserve (size);
+		for (size_t index = 2u; index < raw.size (); index += 2u)
+		{
+			int high = hex_value (raw [index]),
+				low = hex_value (raw [index + 1u]);
+			if (high < 0 || low < 0)
+			{
+				bytes.clear ();
+				return nullptr;
+			}
+			bytes.push_back (high * 16 + low);
+		}
+	}
+
+	return (bytes.size () == size) ? bytes.data () : nullptr;
+}
+
+void
+KDPackedStateBase::store (const void* data, size_t size)
+{
+	String record;
+	record.reserve (2u * (size + 1u));
+	record.push_back (HEX_DIGITS [version >> 4]);
+	record.push_back (HEX_DIGITS [version & 0xfu]);
+
+	const unsigned char* source = static_cast<const unsigned char*> (data);
+	for (size_t index = 0u; index < size; ++index)
+	{
+		record.push_back (HEX_DIGITS [source [index] >> 4]);
+		record.push_back (HEX_DIGITS [source [index] & 0xfu]);
+	}
+
+	// Decoding the new record would only give back the same bytes.
+	blob = record;
+	raw = record;
+	bytes.assign (source, source + size);
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *  KDPackedState.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDPACKEDSTATE_HH
+#define KDPACKEDSTATE_HH
+
+#include <Thief/Thief.hh>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+using namespace Thief;
+
+// Keeps a script's transition state in a single script data record instead of
+// one record per value. The state is a plain struct of trivially copyable
+// members, stored in hex after a version number. A record written with any
+// other version, or not written at all, can't be read, so a script should
+// bump its version whenever the layout of its struct changes.
+class KDPackedStateBase
+{
+public:
+	bool exists () const;
+	void remove ();
+
+protected:
+	KDPackedStateBase (Script& script, const String& name,
+		unsigned version);
+
+	const void* load (size_t size) const;
+	void store (const void* data, size_t size);
+
+private:
+	Persistent<String> blob;
+	unsigned version;
+
+	// The last record decoded, so that each step need not decode it again.
+	mutable String raw;
+	mutable std::vector<unsigned char> bytes;
+};
+
+template <typename T>
+class KDPackedState : public KDPackedStateBase
+{
+	static_assert (std::is_trivially_copyable<T>::value,
+		"KDPackedState stores its state by copying bytes.");
+
+public:
+	KDPackedState (Script& script, const String& name, unsigned version)
+		: KDPackedStateBase (script, name, version)
+	{}
+
+	// Returns false, leaving the state alone, if there is no valid record.
+	bool get (T& state) const
+	{
+		const void* data = load (sizeof (T));
+		if (!data) return false;
+		std::memcpy (&state, data, sizeof (T));
+		return true;
+	}
+
+	void set (const T& state)
+	{
+		store (&state, sizeof (T));
+	}
+};
+
+#endif // KDPACKEDSTATE_HH
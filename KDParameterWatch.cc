@@ -0,0 +1,45 @@
+/******************************************************************************
+ *  KDParameterWatch.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDParameterWatch.hh"
+
+KDParameterWatch::KDParameterWatch
+		(std::initializer_list<const ParameterBase*> _parameters)
+	: parameters (_parameters),
+	  values (_parameters.size ()),
+	  checked (false)
+{}
+
+bool
+KDParameterWatch::check ()
+{
+	bool changed = !checked;
+	for (size_t index = 0u; index < parameters.size (); ++index)
+	{
+		String value = parameters [index]->get_raw ();
+		if (value != values [index])
+		{
+			values [index] = value;
+			changed = true;
+		}
+	}
+	checked = true;
+	return changed;
+}
@@ -0,0 +1,49 @@
+/******************************************************************************
+ *  KDParameterWatch.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDPARAMETERWATCH_HH
+#define KDPARAMETERWATCH_HH
+
+#include <Thief/Thief.hh>
+#include <initializer_list>
+#include <vector>
+using namespace Thief;
+
+// Watches the raw values of a few design note parameters, so that a script
+// can tell which of its derived values a change to the design note affects.
+// A script keeps one watch for each group of parameters that it derives a
+// value from, and only rederives the value when that group's check passes.
+class KDParameterWatch
+{
+public:
+	KDParameterWatch
+		(std::initializer_list<const ParameterBase*> parameters);
+
+	// Returns true on the first check, or if any of the parameters has
+	// changed since the last one.
+	bool check ();
+
+private:
+	std::vector<const ParameterBase*> parameters;
+	std::vector<String> values;
+	bool checked;
+};
+
+#endif // KDPARAMETERWATCH_HH
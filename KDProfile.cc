@@ -0,0 +1,202 @@
+/******************************************************************************
+ *  KDProfile.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDProfile.hh"
+#include <algorithm>
+#include <cstdint>
+
+bool
+KDProfile::enabled = false;
+
+std::map<String, KDProfile::Site>
+KDProfile::sites;
+
+const char* const
+KDProfile::RECORDING_FILE = "KDScript.rec";
+
+bool
+KDProfile::recording = false;
+
+std::ofstream
+KDProfile::recording_file;
+
+int
+KDProfile::recorded_sites = 0;
+
+std::map<String, int>
+KDProfile::recorded_names;
+
+KDProfile::Site&
+KDProfile::get_site (const String& function)
+{
+	// Reduce the full signature to "Class::method".
+	String name = function;
+	size_t end = name.find ('(');
+	if (end != String::npos)
+		name.erase (end);
+	size_t start = name.rfind (' ');
+	if (start != String::npos)
+		name.erase (0, start + 1);
+
+	auto site = sites.find (name);
+	if (site == sites.end ())
+		site = sites.insert (std::make_pair (name, Site (name))).first;
+	return site->second;
+}
+
+bool
+KDProfile::is_enabled ()
+{
+	return enabled;
+}
+
+void
+KDProfile::set_enabled (bool _enabled)
+{
+	if (_enabled && !enabled)
+		reset ();
+	enabled = _enabled;
+}
+
+static bool
+is_busier (const KDProfile::Report& a, const KDProfile::Report& b)
+{
+	return a.timing.total > b.timing.total;
+}
+
+std::vector<KDProfile::Report>
+KDProfile::collect ()
+{
+	std::vector<Report> result;
+	for (auto& site : sites)
+	{
+		if (site.second.timing.calls > 0ul)
+			result.push_back ({ site.first, site.second.timing });
+		for (auto& message : site.second.messages)
+			if (message.second.calls > 0ul)
+				result.push_back ({ site.first + " (" +
+					message.first + ")", message.second });
+	}
+
+	std::sort (result.begin (), result.end (), is_busier);
+	return result;
+}
+
+void
+KDProfile::reset ()
+{
+	for (auto& site : sites)
+	{
+		site.second.timing = Timing ();
+		for (auto& message : site.second.messages)
+			message.second = Timing ();
+	}
+}
+
+
+
+bool
+KDProfile::is_recording ()
+{
+	return recording;
+}
+
+bool
+KDProfile::start_recording ()
+{
+	stop_recording ();
+
+	// Earlier sessions are kept, so that loading a game doesn't lose them.
+	recording_file.open (RECORDING_FILE,
+		std::ios::binary | std::ios::out | std::ios::app);
+	if (!recording_file)
+		return false;
+
+	static const char HEADER [] = { 'K', 'D', 'R', 'E', 'C', 2 };
+	recording_file.write (HEADER, sizeof (HEADER));
+
+	// Sites and names are written again for each new recording.
+	for (auto& site : sites)
+		site.second.recorded_id = -1;
+	recorded_sites = 0;
+	recorded_names.clear ();
+
+	recording = true;
+	return true;
+}
+
+void
+KDProfile::stop_recording ()
+{
+	if (recording_file.is_open ())
+		recording_file.close ();
+	recording = false;
+}
+
+template <typename T>
+static void
+write_value (std::ofstream& file, T value)
+{
+	file.write (reinterpret_cast<const char*> (&value), sizeof (T));
+}
+
+void
+KDProfile::write_name (char tag, int id, const String& name)
+{
+	uint8_t length = std::min<size_t> (name.size (), 255u);
+	recording_file.put (tag);
+	write_value<uint16_t> (recording_file, id);
+	write_value<uint8_t> (recording_file, length);
+	recording_file.write (name.data (), length);
+}
+
+void
+KDProfile::record_message (Site& site, Message& message,
+	Clock::duration time)
+{
+	if (site.recorded_id < 0)
+	{
+		site.recorded_id = recorded_sites++;
+		write_name ('S', site.recorded_id, site.name);
+	}
+
+	String name = message.get_name ();
+	auto known = recorded_names.find (name);
+	if (known == recorded_names.end ())
+	{
+		int id = int (recorded_names.size ());
+		known = recorded_names.insert (std::make_pair (name, id)).first;
+		write_name ('N', id, name);
+	}
+
+	recording_file.put ('M');
+	write_value<uint16_t> (recording_file, site.recorded_id);
+	write_value<uint16_t> (recording_file, known->second);
+	write_value<uint32_t> (recording_file,
+		static_cast<unsigned long> (message.get_time ()));
+	write_value<int32_t> (recording_file, message.get_from ().number);
+	write_value<int32_t> (recording_file, message.get_to ().number);
+	write_value<uint32_t> (recording_file, std::chrono::duration_cast
+		<std::chrono::microseconds> (time).count ());
+
+	// A failed write (such as a full disk) ends the recording.
+	if (!recording_file)
+		stop_recording ();
+}
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *  KDProfile.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDPROFILE_HH
+#define KDPROFILE_HH
+
+#include <Thief/Thief.hh>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <vector>
+using namespace Thief;
+
+// Times the message handlers, HUD callbacks and transition steps of the
+// module's scripts. Each timed function is a site, which keeps the calls,
+// total time and longest time of that function since the last report. Times
+// are inclusive of any timed functions called in turn. While profiling is
+// off, which is the default, a call costs only a check of one flag. KDGetInfo
+// turns it on and reports the results.
+//
+// KDHUDElement times the prepare and redraw of every element it derives.
+// ThiefLib dispatches messages, timers and transition steps itself, without a
+// hook for the module, so those functions start with KD_PROFILE () instead.
+// Message handlers start with KD_PROFILE_MESSAGE (message), which times each
+// message name that a handler serves separately. While a recording is open,
+// the timing of each message they handle is also appended to it, so a slow
+// stretch of a mission can be studied after the fact. Only the message's
+// name, sender and recipient are kept, not its data, so it can't be replayed.
+// The recording is always RECORDING_FILE in the game directory. Each session,
+// which starts when a mission or saved game is loaded, is appended to the file
+// after a header of "KDREC" and a version byte, as ids start over with it. It
+// is binary, in the machine's byte order, and is a series of records, each
+// starting with a tag byte:
+//	'S' site: uint16 id, uint8 length, name
+//	'N' message name: uint16 id, uint8 length, name
+//	'M' message: uint16 site id, uint16 name id, uint32 sim time (ms),
+//	    int32 from, int32 to, uint32 handler time (us)
+// Each site and message name is written once, before its first use. A
+// message is written when its handler returns, so a message handled inside
+// another handler comes first.
+class KDProfile
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Timing
+	{
+		Timing ()
+			: calls (0ul),
+			  total (Clock::duration::zero ()),
+			  longest (Clock::duration::zero ())
+		{}
+
+		void record (Clock::duration time)
+		{
+			++calls;
+			total += time;
+			if (time > longest) longest = time;
+		}
+
+		unsigned long calls;
+		Clock::duration total, longest;
+	};
+
+	struct Site
+	{
+		Site (const String& _name) : name (_name), recorded_id (-1) {}
+
+		Timing& get_timing (Message* message)
+		{
+			if (!message) return timing;
+			return messages [message->get_name ()];
+		}
+
+		String name;
+		Timing timing;
+		std::map<String, Timing> messages;
+		int recorded_id;
+	};
+
+	// Returns the site of a function, given its name or full signature.
+	static Site& get_site (const String& function);
+
+	class Guard
+	{
+	public:
+		Guard (Site& _site, Message* _message = nullptr)
+			: site ((enabled || recording) ? &_site : nullptr),
+			  timing (site ? &site->get_timing (_message)
+				: nullptr),
+			  message (recording ? _message : nullptr)
+		{
+			if (site) start = Clock::now ();
+		}
+
+		~Guard ()
+		{
+			if (!site) return;
+			Clock::duration time = Clock::now () - start;
+			timing->record (time);
+			if (message) record_message (*site, *message, time);
+		}
+
+	private:
+		Site* site;
+		Timing* timing;
+		Message* message;
+		Clock::time_point start;
+	};
+
+	static bool is_enabled ();
+	static void set_enabled (bool enabled);
+
+	// Returns the timings of the sites called since the last reset, busiest
+	// first. A handler's timing for each message is named after both.
+	struct Report
+	{
+		String name;
+		Timing timing;
+	};
+	static std::vector<Report> collect ();
+	static void reset ();
+
+	static const char* const RECORDING_FILE;
+	static bool is_recording ();
+	static bool start_recording ();
+	static void stop_recording ();
+
+private:
+	static bool enabled;
+	static std::map<String, Site> sites;
+
+	static void record_message (Site& site, Message& message,
+		Clock::duration time);
+	static void write_name (char tag, int id, const String& name);
+
+	static bool recording;
+	static std::ofstream recording_file;
+	static int recorded_sites;
+	static std::map<String, int> recorded_names;
+};
+
+#define KD_PROFILE() \
+	static KDProfile::Site& kd_profile_site = \
+		KDProfile::get_site (__PRETTY_FUNCTION__); \
+	KDProfile::Guard kd_profile_guard (kd_profile_site)
+
+#define KD_PROFILE_MESSAGE(Received) \
+	static KDProfile::Site& kd_profile_site = \
+		KDProfile::get_site (__PRETTY_FUNCTION__); \
+	KDProfile::Guard kd_profile_guard (kd_profile_site, &(Received))
+
+#endif // KDPROFILE_HH
@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDQuestArrow.hh"
+#include "KDProfile.hh"
 
 
 
@@ -46,6 +47,7 @@ KDQuestArrow::KDQuestArrow (const String& _name, const Object& _host)
 	  THIEF_PARAMETER_FULL (_text, "quest_arrow_text", "@name"),
 	  THIEF_PARAMETER_FULL (color, "quest_arrow_color", Color (0xffffff)),
 	  THIEF_PARAMETER_FULL (shadow, "quest_arrow_shadow", true),
+	  text_watch ({ &_text, &objective }),
 	  direction (Direction::NONE),
 	  image_pos (),
 	  text_pos ()
@@ -75,6 +77,7 @@ KDQuestArrow::initialize ()
 	// for quest_arrow_text == "@name"
 	ObjectProperty::subscribe ("GameName", host ());
 
+	text_watch.check ();
 	update_text ();
 }
 
@@ -98,7 +101,7 @@ subst_distance (const String& text, int distance)
 }
 
 bool
-KDQuestArrow::prepare ()
+KDQuestArrow::prepare_element ()
 {
 	// Confirm that the arrow is enabled.
 	if (!enabled) return false;
@@ -173,7 +176,7 @@ KDQuestArrow::prepare ()
 }
 
 void
-KDQuestArrow::redraw ()
+KDQuestArrow::redraw_element ()
 {
 	set_drawing_color (color);
 
@@ -195,16 +198,18 @@ KDQuestArrow::redraw ()
 
 
 Message::Result
-KDQuestArrow::on_on (Message&)
+KDQuestArrow::on_on (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	enabled = true;
 	return Message::HALT;
 }
 
 
 Message::Result
-KDQuestArrow::on_off (Message&)
+KDQuestArrow::on_off (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	enabled = false;
 	return Message::HALT;
 }
@@ -212,6 +217,7 @@ KDQuestArrow::on_off (Message&)
 Message::Result
 KDQuestArrow::on_contained (ContainmentMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.event == ContainmentMessage::ADD &&
 	    message.container == Player ())
 		enabled = false;
@@ -221,6 +227,7 @@ KDQuestArrow::on_contained (ContainmentMessage& message)
 Message::Result
 KDQuestArrow::on_ai_mode_change (AIModeMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.new_mode == AI::Mode::DEAD)
 		enabled = false;
 	return Message::HALT;
@@ -231,8 +238,14 @@ KDQuestArrow::on_ai_mode_change (AIModeMessage& message)
 Message::Result
 KDQuestArrow::on_property_change (PropertyMessage& message)
 {
-	if (message.property == Property ("DesignNote") ||
-		message.property == Property ("GameName"))
+	KD_PROFILE_MESSAGE (message);
+	if (message.property == KDHandles::get_property ("DesignNote"))
+	{
+		schedule_redraw ();
+		if (text_watch.check ())
+			update_text ();
+	}
+	else if (message.property == KDHandles::get_property ("GameName"))
 	{
 		schedule_redraw ();
 		update_text ();
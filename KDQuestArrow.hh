@@ -22,6 +22,8 @@
 #define KDQUESTARROW_HH
 
 #include "KDHUDElement.hh"
+#include "KDHandles.hh"
+#include "KDParameterWatch.hh"
 
 class KDQuestArrow : public Script, public KDHUDElement
 {
@@ -32,8 +34,8 @@ private:
 	virtual void initialize ();
 	virtual void deinitialize ();
 
-	virtual bool prepare ();
-	virtual void redraw ();
+	virtual bool prepare_element ();
+	virtual void redraw_element ();
 
 	Message::Result on_on (Message&);
 	Message::Result on_off (Message&);
@@ -57,6 +59,8 @@ private:
 	Parameter<Color> color;
 	Parameter<bool> shadow;
 
+	KDParameterWatch text_watch;
+
 	Direction direction;
 	CanvasPoint image_pos;
 	CanvasPoint text_pos;
@@ -19,38 +19,99 @@
  *****************************************************************************/
 
 #include "KDRenewable.hh"
+#include "KDProfile.hh"
+#include "KDTimerWheel.hh"
+
+// The stock elemental crystals have no Transmute links to the arrows they
+// become, so their inventory types are looked up here by archetype name.
+static const std::map<CIString, CIString>
+crystal_types =
+{
+	{ "EarthCrystal", "EarthArrow" },
+	{ "WaterCrystal", "water" },
+	{ "FireCrystal", "firearr" },
+	{ "AirCrystal", "GasArrow" },
+};
 
 KDRenewable::KDRenewable (const String& _name, const Object& _host)
 	: Script (_name, _host),
 	  THIEF_PARAMETER_FULL (frequency, "renewable_frequency", 180000ul),
 	  THIEF_PARAMETER_FULL (threshold, "renewable_threshold", 0),
-	  THIEF_PARAMETER_FULL (physical, "renewable_physical", false)
+	  THIEF_PARAMETER_FULL (physical, "renewable_physical", false),
+	  THIEF_PERSISTENT_FULL (resource, Object::NONE),
+	  THIEF_PERSISTENT_FULL (inventory_type, Object::NONE),
+	  THIEF_PERSISTENT_FULL (resource_threshold, 0)
 {
 	listen_message ("PostSim", &KDRenewable::on_post_sim);
+	listen_timer ("RenewPhase", &KDRenewable::on_renew_phase);
 	listen_timer ("Renew", &KDRenewable::on_renew);
+	listen_message ("PropertyChange", &KDRenewable::on_property_change);
+}
+
+void
+KDRenewable::initialize ()
+{
+	Script::initialize ();
+	ObjectProperty::subscribe ("DesignNote", host ());
+}
+
+void
+KDRenewable::deinitialize ()
+{
+	ObjectProperty::unsubscribe ("DesignNote", host ());
+	Script::deinitialize ();
 }
 
 Message::Result
-KDRenewable::on_post_sim (Message&)
+KDRenewable::on_post_sim (Message& message)
 {
-	// This non-standard use of the Script->Timing property is kept for
-	// backwards compatibility with miss16.osm's RenewableResource.
-	Time delay = frequency;
-	if (host ().script_timing.exists () && !frequency.exists ())
-		delay = 1000ul * Time (host ().script_timing);
+	KD_PROFILE_MESSAGE (message);
+	resolve_resource ();
 
+	Time delay = get_delay ();
 	if (delay != 0ul)
 	{
 		TimerMessage ("Renew").send (host (), host ());
-		start_timer ("Renew", delay, true);
+
+		// Offset the repeating timer so that renewables with the same
+		// frequency don't all fire in the same frame.
+		Time phase = KDTimerWheel::get_phase (host (), delay);
+		start_timer ("RenewPhase", phase, false);
 	}
 
 	return Message::HALT;
 }
 
 Message::Result
-KDRenewable::on_renew (TimerMessage&)
+KDRenewable::on_renew_phase (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	start_timer ("Renew", get_delay (), true);
+	return Message::HALT;
+}
+
+Time
+KDRenewable::get_delay ()
 {
+	// This non-standard use of the Script->Timing property is kept for
+	// backwards compatibility with miss16.osm's RenewableResource.
+	Time delay = frequency;
+	if (host ().script_timing.exists () && !frequency.exists ())
+		delay = 1000ul * Time (host ().script_timing);
+	return delay;
+}
+
+Message::Result
+KDRenewable::on_renew (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	// If too many periodic scripts are running now, try again shortly.
+	if (!KDTimerWheel::admit (message.get_time ()))
+	{
+		start_timer ("Renew", KDTimerWheel::SLOT_LENGTH, false);
+		return Message::HALT;
+	}
+
 	Player player;
 
 	// Check for a previously created instance.
@@ -63,9 +124,38 @@ KDRenewable::on_renew (TimerMessage&)
 			return Message::HALT;
 	}
 
+	// Identify the resource, if this wasn't done at PostSim or its link
+	// has been removed since.
+	if (!resource.exists () || (resource != Object::NONE &&
+	    Link::get_one ("ScriptParams", host (), resource) == Link::NONE))
+		resolve_resource ();
+	if (resource == Object::NONE)
+		return Message::HALT;
+
+	// Check the inventory count.
+	if (count_inventory (inventory_type) >= size_t (resource_threshold))
+		return Message::HALT;
+
+	// Create new instance.
+	Physical instance = Object::start_create (resource);
+	instance.set_position (Vector (), Vector (), host ());
+	Link::create ("Owns", host (), instance);
+
+	// Remove the instance's physics, if required.
+	if (!physical)
+		instance.remove_physics ();
+
+	instance.finish_create ();
+	log (Log::NORMAL, "Created new renewable instance %||.", instance);
+	return Message::HALT;
+}
+
+void
+KDRenewable::resolve_resource ()
+{
 	// Identify the resource archetype and stack count threshold.
 	Object archetype;
-	size_t my_threshold = 0u;
+	int my_threshold = 0;
 	for (auto& script_param : ScriptParamsLink::get_all (host ()))
 	{
 		if (CIString ("Renewable") == script_param.data)
@@ -84,8 +174,6 @@ KDRenewable::on_renew (TimerMessage&)
 		}
 		catch (...) {}
 	}
-	if (archetype == Object::NONE)
-		return Message::HALT;
 
 	// Transmogrify the archetype for the inventory check.
 	Object inv_type = archetype;
@@ -93,34 +181,35 @@ KDRenewable::on_renew (TimerMessage&)
 		Link::Inheritance::SOURCE);
 	if (!transmute.empty ())
 		inv_type = transmute.front ().get_dest ();
-	else if (archetype == Object ("EarthCrystal"))
-		inv_type = Object ("EarthArrow");
-	else if (archetype == Object ("WaterCrystal"))
-		inv_type = Object ("water");
-	else if (archetype == Object ("FireCrystal"))
-		inv_type = Object ("firearr");
-	else if (archetype == Object ("AirCrystal"))
-		inv_type = Object ("GasArrow");
-
-	// Check the inventory count.
-	size_t inv_count = 0;
-	for (auto& content : player.get_inventory ())
-		if (content.object.inherits_from (inv_type))
-			inv_count += Combinable (content.object).stack_count;
-	if (inv_count >= my_threshold)
-		return Message::HALT;
-
-	// Create new instance.
-	Physical instance = Object::start_create (archetype);
-	instance.set_position (Vector (), Vector (), host ());
-	Link::create ("Owns", host (), instance);
+	else if (archetype != Object::NONE)
+	{
+		auto crystal = crystal_types.find
+			(CIString (archetype.get_name ().data ()));
+		if (crystal != crystal_types.end ())
+			inv_type = Object (String (crystal->second.data ()));
+	}
 
-	// Remove the instance's physics, if required.
-	if (!physical)
-		instance.remove_physics ();
+	resource = archetype;
+	inventory_type = inv_type;
+	resource_threshold = my_threshold;
+}
 
-	instance.finish_create ();
-	log (Log::NORMAL, "Created new renewable instance %||.", instance);
+Message::Result
+KDRenewable::on_property_change (PropertyMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	// The threshold may have changed.
+	if (message.property == KDHandles::get_property ("DesignNote"))
+		resolve_resource ();
 	return Message::HALT;
 }
 
+size_t
+KDRenewable::count_inventory (const Object& type)
+{
+	size_t count = 0;
+	for (auto& content : Player ().get_inventory ())
+		if (content.object.inherits_from (type))
+			count += Combinable (content.object).stack_count;
+	return count;
+}
@@ -21,8 +21,8 @@
 #ifndef KDRENEWABLE_HH
 #define KDRENEWABLE_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHandles.hh"
+#include <map>
 
 class KDRenewable : public Script
 {
@@ -30,12 +30,24 @@ public:
 	KDRenewable (const String& name, const Object& host);
 
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
 	Message::Result on_post_sim (Message&);
+	Message::Result on_renew_phase (TimerMessage&);
 	Message::Result on_renew (TimerMessage&);
+	Time get_delay ();
 
 	Parameter<Time> frequency;
 	Parameter<int> threshold;
 	Parameter<bool> physical;
+
+	void resolve_resource ();
+	Message::Result on_property_change (PropertyMessage&);
+	Persistent<Object> resource, inventory_type;
+	Persistent<int> resource_threshold;
+
+	static size_t count_inventory (const Object& type);
 };
 
 #endif // KDRENEWABLE_HH
@@ -19,9 +19,37 @@
  *****************************************************************************/
 
 #include "KDRoomAmbient.hh"
+#include "KDProfile.hh"
+
+const char* const
+KDRoomAmbient::FNORD_NAMES [2] = { "KDRoomAmbient", "KDRoomAmbient2" };
+
+const int
+KDRoomAmbient::SILENT_VOLUME = -5000;
+
+Object
+KDRoomAmbient::owner;
+
+int
+KDRoomAmbient::last_claim = 0;
+
+bool
+KDRoomAmbient::owner_known = false;
+
+size_t
+KDRoomAmbient::rooms = 0u;
 
 KDRoomAmbient::KDRoomAmbient (const String& _name, const Object& _host)
-	: Script (_name, _host)
+	: Script (_name, _host),
+	  fade (*this, &KDRoomAmbient::step_fade, "RoomAmbientFade", 100ul,
+		1000ul, Curve::LINEAR, "room_ambient_fade",
+		"room_ambient_curve"),
+	  THIEF_PERSISTENT (fade_in),
+	  THIEF_PERSISTENT (fade_out),
+	  THIEF_PERSISTENT (fade_in_start),
+	  THIEF_PERSISTENT (fade_in_end),
+	  THIEF_PERSISTENT (fade_out_start),
+	  THIEF_PERSISTENT (claim)
 {
 	listen_message ("PlayerRoomEnter", &KDRoomAmbient::on_player_enter);
 	listen_message ("PropertyChange", &KDRoomAmbient::on_property_change);
@@ -32,6 +60,14 @@ KDRoomAmbient::initialize ()
 {
 	Script::initialize ();
 	ObjectProperty::subscribe ("Ambient", host ());
+
+	++rooms;
+	if (claim.exists () && claim > last_claim)
+	{
+		last_claim = claim;
+		owner = host ();
+		owner_known = true;
+	}
 }
 
 void
@@ -39,11 +75,20 @@ KDRoomAmbient::deinitialize ()
 {
 	Script::deinitialize ();
 	ObjectProperty::unsubscribe ("Ambient", host ());
+
+	// The owner is rebuilt from the claims when a game is loaded.
+	if (rooms > 0u && --rooms == 0u)
+	{
+		owner = Object ();
+		last_claim = 0;
+		owner_known = false;
+	}
 }
 
 Message::Result
-KDRoomAmbient::on_player_enter (Message&)
+KDRoomAmbient::on_player_enter (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	set_owning_room ();
 	set_ambient ();
 	return Message::CONTINUE;
@@ -52,23 +97,26 @@ KDRoomAmbient::on_player_enter (Message&)
 Message::Result
 KDRoomAmbient::on_property_change (PropertyMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Only proceed for a change in the Room\Ambient property on this room
 	// while it owns the environmental ambient and the mission is running.
-	if (is_sim () && message.property == Property ("Ambient") &&
+	if (is_sim () &&
+	    message.property == KDHandles::get_property ("Ambient") &&
 	    message.object == host () && is_owning_room ())
 		set_ambient ();
 	return Message::CONTINUE;
 }
 
 AmbientHacked
-KDRoomAmbient::get_fnord (bool create)
+KDRoomAmbient::get_fnord (unsigned buffer, bool create)
 {
-	AmbientHacked fnord ("KDRoomAmbient");
+	AmbientHacked fnord (FNORD_NAMES [buffer]);
 	if (!fnord.exists () && create)
 	{
-		log (Log::VERBOSE, "Creating the KDRoomAmbient fnord.");
+		log (Log::VERBOSE, "Creating the %|| fnord.",
+			FNORD_NAMES [buffer]);
 		fnord = Object::create (Object ("Marker"));
-		fnord.set_name ("KDRoomAmbient");
+		fnord.set_name (FNORD_NAMES [buffer]);
 		fnord.set_location (Vector ()); // at the origin
 	}
 	return fnord;
@@ -77,40 +125,106 @@ KDRoomAmbient::get_fnord (bool create)
 bool
 KDRoomAmbient::is_owning_room ()
 {
-	auto fnord = get_fnord (false);
-	return fnord.exists () && host () == ScriptParamsLink::get_one_by_data
-		(fnord, "Room").get_dest ();
+	// No room has claimed the ambient since the game was loaded. Games
+	// saved by older versions recorded the owner in a link from the fnord.
+	if (!owner_known)
+	{
+		auto fnord = get_fnord (0u, false);
+		if (fnord.exists ())
+			owner = ScriptParamsLink::get_one_by_data
+				(fnord, "Room").get_dest ();
+		owner_known = true;
+	}
+	return owner == host ();
 }
 
 void
 KDRoomAmbient::set_owning_room ()
 {
-	auto fnord = get_fnord ();
-	for (auto& link : ScriptParamsLink::get_all_by_data (fnord, "Room"))
-		link.destroy ();
-	ScriptParamsLink::create (fnord, host (), "Room");
+	if (is_owning_room ()) return;
+	owner = host ();
+	owner_known = true;
+	claim = ++last_claim;
+}
+
+bool
+KDRoomAmbient::is_playing (AmbientHacked& fnord)
+{
+	return !String (fnord.ambient_schema [0u]).empty () && fnord.active;
 }
 
 void
 KDRoomAmbient::set_ambient ()
 {
-	auto fnord = get_fnord ();
 	auto room = host_as<Room> ();
 	String schema = room.ambient_schema;
 	int volume = room.ambient_volume;
 
-	// Only proceed if a schema was specified and something has changed.
-	if (schema.empty () || (schema == String (fnord.ambient_schema [0u]) &&
-	    volume == fnord.ambient_volume))
-		return;
+	// Only proceed if a schema was specified.
+	if (schema.empty ()) return;
+
+	// The two fnords are used as a double buffer. If either is already
+	// playing this schema, its volume is simply retargeted. Otherwise, the
+	// schema is started on the free (or quieter) one. The other one is
+	// faded out as the first is faded in.
+	AmbientHacked first = get_fnord (0u), second = get_fnord (1u),
+		incoming, outgoing;
+	if (is_playing (first) && schema == String (first.ambient_schema [0u]))
+		{ incoming = first; outgoing = second; }
+	else if (is_playing (second) &&
+	    schema == String (second.ambient_schema [0u]))
+		{ incoming = second; outgoing = first; }
+	else
+	{
+		bool first_free = !is_playing (first) ||
+			(is_playing (second) && int (first.ambient_volume) <=
+				int (second.ambient_volume));
+		incoming = first_free ? first : second;
+		outgoing = first_free ? second : first;
 
-	log (Log::NORMAL, "Playing room environmental ambient %|| "
-		"at volume %||.", schema, volume);
+		log (Log::NORMAL, "Playing room environmental ambient %|| "
+			"at volume %||.", schema, volume);
+
+		incoming.active.remove (); // remove old AmbientHacked
+		incoming.ambient_schema [0u] = schema;
+		incoming.ambient_volume = SILENT_VOLUME;
+		incoming.ambient_radius = 2000.0; // reaches everywhere
+		incoming.environmental = true;
+	}
+
+	// Only proceed if something has changed.
+	if (incoming.ambient_volume == volume && !is_playing (outgoing))
+		return;
 
-	fnord.active.remove (); // remove old AmbientHacked
-	fnord.ambient_schema [0u] = schema;
-	fnord.ambient_volume = volume;
-	fnord.ambient_radius = 2000.0; // reaches everywhere
-	fnord.environmental = true;
+	fade_in = incoming;
+	fade_in_start = incoming.ambient_volume;
+	fade_in_end = volume;
+	fade_out = outgoing;
+	fade_out_start = is_playing (outgoing)
+		? int (outgoing.ambient_volume) : SILENT_VOLUME;
+	fade.start ();
 }
 
+bool
+KDRoomAmbient::step_fade ()
+{
+	KD_PROFILE ();
+	// Stop if another room has taken over the environmental ambient.
+	if (!is_owning_room ()) return false;
+
+	AmbientHacked incoming = fade_in, outgoing = fade_out;
+	incoming.ambient_volume = std::lround (fade.interpolate
+		(float (fade_in_start), float (fade_in_end)));
+
+	if (is_playing (outgoing))
+	{
+		if (fade.get_progress () < 1.0f)
+			outgoing.ambient_volume = std::lround
+				(fade.interpolate (float (fade_out_start),
+					float (SILENT_VOLUME)));
+		else
+			outgoing.active = false;
+	}
+
+	return true;
+}
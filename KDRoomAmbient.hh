@@ -21,8 +21,7 @@
 #ifndef KDROOMAMBIENT_HH
 #define KDROOMAMBIENT_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHandles.hh"
 
 class KDRoomAmbient : public Script
 {
@@ -36,10 +35,30 @@ private:
 	Message::Result on_player_enter (Message&);
 	Message::Result on_property_change (PropertyMessage&);
 
-	AmbientHacked get_fnord (bool create = true);
+	AmbientHacked get_fnord (unsigned buffer, bool create = true);
 	bool is_owning_room ();
 	void set_owning_room ();
+
+	bool is_playing (AmbientHacked& fnord);
 	void set_ambient ();
+	bool step_fade ();
+
+	Transition fade;
+	Persistent<Object> fade_in, fade_out;
+	Persistent<int> fade_in_start, fade_in_end, fade_out_start;
+
+	// The owner is the room that claimed the ambient most recently. Each
+	// room saves the number of its own latest claim, from which the rooms
+	// rebuild the owner in memory as they are initialized.
+	Persistent<int> claim;
+
+	static const char* const FNORD_NAMES [2];
+	static const int SILENT_VOLUME;
+
+	static Object owner;
+	static int last_claim;
+	static bool owner_known;
+	static size_t rooms;
 };
 
 #endif // KDROOMAMBIENT_HH
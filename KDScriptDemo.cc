@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDScriptDemo.hh"
+#include "KDProfile.hh"
 
 KDScriptDemo::KDScriptDemo (const String& _name, const Object& _host)
 	: Script (_name, _host),
@@ -33,6 +34,7 @@ KDScriptDemo::KDScriptDemo (const String& _name, const Object& _host)
 Message::Result
 KDScriptDemo::on_sim (SimMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.event != SimMessage::START)
 		return Message::CONTINUE;
 	for (auto& link : ScriptParamsLink::get_all_by_data (host (), "Enable"))
@@ -43,15 +45,17 @@ KDScriptDemo::on_sim (SimMessage& message)
 }
 
 Message::Result
-KDScriptDemo::on_turn_on (Message&)
+KDScriptDemo::on_turn_on (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Room ("DemoArena").ambient_schema = on_ambient;
 	return Message::HALT;
 }
 
 Message::Result
-KDScriptDemo::on_turn_off (Message&)
+KDScriptDemo::on_turn_off (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Room ("DemoArena").ambient_schema = off_ambient;
 	return Message::HALT;
 }
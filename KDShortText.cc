@@ -19,9 +19,20 @@
  *****************************************************************************/
 
 #include "KDShortText.hh"
+#include "KDProfile.hh"
+
+Object::Number
+KDShortText::last_host = Object::NONE;
+
+unsigned long
+KDShortText::last_shown = 0ul;
+
+unsigned long
+KDShortText::last_duration = 0ul;
 
 KDShortText::KDShortText (const String& _name, const Object& _host)
 	: Script (_name, _host),
+	  text_known (false),
 	  THIEF_PARAMETER (text),
 	  THIEF_PARAMETER (text_color, Color (0xffffff)),
 	  THIEF_PARAMETER (text_time),
@@ -30,32 +41,86 @@ KDShortText::KDShortText (const String& _name, const Object& _host)
 {
 	listen_message ("WorldSelect", &KDShortText::on_focus);
 	listen_message ("FrobWorldEnd", &KDShortText::on_frob);
+	listen_message ("PropertyChange", &KDShortText::on_property_change);
+}
+
+void
+KDShortText::initialize ()
+{
+	Script::initialize ();
+	ObjectProperty::subscribe ("Book", host ());
+	ObjectProperty::subscribe ("DesignNote", host ());
+}
+
+void
+KDShortText::deinitialize ()
+{
+	Script::deinitialize ();
+	ObjectProperty::unsubscribe ("Book", host ());
+	ObjectProperty::unsubscribe ("DesignNote", host ());
 }
 
 Message::Result
-KDShortText::on_focus (Message&)
+KDShortText::on_focus (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (text_on_focus)
-		show_text ();
+		show_text (message.get_time (), true);
 	return Message::HALT;
 }
 
 Message::Result
-KDShortText::on_frob (FrobMessage&)
+KDShortText::on_frob (FrobMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (text_on_frob)
-		show_text ();
+		show_text (message.get_time (), false);
 	return Message::HALT;
 }
 
+Message::Result
+KDShortText::on_property_change (PropertyMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	// The text may come from either property, so look it up again.
+	if (message.object == host ())
+		text_known = false;
+	return Message::HALT;
+}
+
+const String&
+KDShortText::get_text ()
+{
+	if (!text_known)
+	{
+		String msgid = host_as<Readable> ().book_name;
+		if (msgid.empty ()) msgid = text;
+		cached_text = Interface::get_text ("strings", "short", msgid);
+		text_known = true;
+	}
+	return cached_text;
+}
+
 void
-KDShortText::show_text ()
+KDShortText::show_text (Time _now, bool debounce)
 {
-	String msgid = host_as<Readable> ().book_name;
-	if (msgid.empty ()) msgid = text;
+	const String& msgstr = get_text ();
+	if (msgstr.empty ()) return;
+
+	// Don't reshow the text on renewed focus while it is still showing.
+	unsigned long now = static_cast<unsigned long> (_now);
+	if (debounce && last_host == host ().number &&
+	    now >= last_shown && now < last_shown + last_duration)
+		return;
+
+	Time duration = text_time;
+	last_host = host ().number;
+	last_shown = now;
+	last_duration = static_cast<unsigned long> (duration)
+		? static_cast<unsigned long> (duration)
+		: static_cast<unsigned long>
+			(Interface::calc_text_duration (msgstr));
 
-	String msgstr = Interface::get_text ("strings", "short", msgid);
-	if (!msgstr.empty ())
-		Interface::show_text (msgstr, text_time, text_color);
+	Interface::show_text (msgstr, text_time, text_color);
 }
 
@@ -30,10 +30,22 @@ public:
 	KDShortText (const String& name, const Object& host);
 
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
 	Message::Result on_focus (Message&);
 	Message::Result on_frob (FrobMessage&);
+	Message::Result on_property_change (PropertyMessage&);
+
+	const String& get_text ();
+	void show_text (Time now, bool debounce);
+
+	String cached_text;
+	bool text_known;
 
-	void show_text ();
+	// The most recent text shown by any instance.
+	static Object::Number last_host;
+	static unsigned long last_shown, last_duration;
 
 	Parameter<String> text;
 	Parameter<Color> text_color;
@@ -19,14 +19,21 @@
  *****************************************************************************/
 
 #include "KDSnuffable.hh"
+#include "KDProfile.hh"
+
+KDSnuffable::Groups
+KDSnuffable::groups;
 
 KDSnuffable::KDSnuffable (const String& _name, const Object& _host)
 	: Script (_name, _host),
+	  THIEF_PERSISTENT_FULL (request_pending, false),
+	  THIEF_PERSISTENT_FULL (requested_on, false),
 	  THIEF_PERSISTENT_FULL (on_mode, AnimLight::Mode::MAXIMUM),
 	  THIEF_PERSISTENT_FULL (off_mode, AnimLight::Mode::ZERO),
 	  THIEF_PARAMETER (relight_on_frob, false),
 	  THIEF_PARAMETER (light_on_schema, Object::NONE),
-	  THIEF_PARAMETER (light_off_schema, Object::NONE)
+	  THIEF_PARAMETER (light_off_schema, Object::NONE),
+	  THIEF_PARAMETER (snuff_group)
 {
 	listen_message ("PostSim", &KDSnuffable::on_post_sim);
 
@@ -41,12 +48,19 @@ KDSnuffable::KDSnuffable (const String& _name, const Object& _host)
 
 	listen_message ("Toggle", &KDSnuffable::toggle);
 	listen_message ("FrobWorldEnd", &KDSnuffable::toggle);
+
+	listen_message ("SnuffBatch", &KDSnuffable::on_batch);
+
+	listen_message ("GroupTurnOn", &KDSnuffable::on_group);
+	listen_message ("GroupTurnOff", &KDSnuffable::on_group);
+	listen_message ("GroupToggle", &KDSnuffable::on_group);
 }
 
 void
 KDSnuffable::initialize ()
 {
 	Script::initialize ();
+
 	if (!on_mode.exists () || !off_mode.exists ())
 	{
 		AnimLight::Mode mode = host_as<AnimLight> ().light_mode;
@@ -68,11 +82,39 @@ KDSnuffable::initialize ()
 			break;
 		}
 	}
+
+	registered_group = snuff_group;
+	if (!registered_group.empty ())
+		groups.insert (std::make_pair (registered_group,
+			host ().number));
+
+	KDHandles::attach ();
+
+	// A request may have been saved before its batch was delivered.
+	if (request_pending)
+		GenericMessage ("SnuffBatch").post (host (), host ());
+}
+
+void
+KDSnuffable::deinitialize ()
+{
+	KDHandles::detach ();
+	Script::deinitialize ();
+
+	auto range = groups.equal_range (registered_group);
+	for (auto member = range.first; member != range.second; ++member)
+		if (member->second == host ().number)
+		{
+			groups.erase (member);
+			break;
+		}
+	registered_group.clear ();
 }
 
 Message::Result
-KDSnuffable::on_post_sim (Message&)
+KDSnuffable::on_post_sim (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (host_as<AnimLight> ().light_mode == on_mode)
 		on_common ();
 	else
@@ -82,13 +124,21 @@ KDSnuffable::on_post_sim (Message&)
 }
 
 Message::Result
-KDSnuffable::turn_on (Message&)
+KDSnuffable::turn_on (Message& message)
 {
-	auto light = host_as<AnimLight> ();
-	if (light.light_mode == on_mode) return Message::HALT;
+	KD_PROFILE_MESSAGE (message);
+	request (true);
+	return Message::HALT;
+}
+
+void
+KDSnuffable::light ()
+{
+	auto anim_light = host_as<AnimLight> ();
+	if (anim_light.light_mode == on_mode) return;
 
 	log (Log::NORMAL, "Lighting snuffable light.");
-	light.light_mode = on_mode;
+	anim_light.light_mode = on_mode;
 	on_common ();
 
 	if (light_on_schema->exists ())
@@ -96,13 +146,12 @@ KDSnuffable::turn_on (Message&)
 	else
 		SoundSchema::play_by_tags ("Event Activate",
 			SoundSchema::Tagged::ON_OBJECT, host ());
-
-	return Message::HALT;
 }
 
 void
 KDSnuffable::on_common ()
 {
+	KD_PROFILE ();
 	host_as<Rendered> ().self_illumination = 1.0f;
 
 	auto sound = host_as<AmbientHacked> ();
@@ -124,17 +173,25 @@ KDSnuffable::on_common ()
 	GenericMessage ("TurnOn").broadcast (host (), "~ParticleAttachement");
 
 	if (!relight_on_frob)
-		host ().remove_metaprop (Object ("FrobInert"));
+		host ().remove_metaprop (KDHandles::get_object ("FrobInert"));
 }
 
 Message::Result
-KDSnuffable::turn_off (Message&)
+KDSnuffable::turn_off (Message& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	request (false);
+	return Message::HALT;
+}
+
+void
+KDSnuffable::snuff ()
 {
-	auto light = host_as<AnimLight> ();
-	if (light.light_mode == off_mode) return Message::HALT;
+	auto anim_light = host_as<AnimLight> ();
+	if (anim_light.light_mode == off_mode) return;
 
 	log (Log::NORMAL, "Extinguishing snuffable light.");
-	light.light_mode = off_mode;
+	anim_light.light_mode = off_mode;
 	off_common ();
 
 	if (light_off_schema->exists ())
@@ -142,13 +199,12 @@ KDSnuffable::turn_off (Message&)
 	else
 		SoundSchema::play_by_tags ("Event Deactivate",
 			SoundSchema::Tagged::ON_OBJECT, host ());
-
-	return Message::HALT;
 }
 
 void
 KDSnuffable::off_common ()
 {
+	KD_PROFILE ();
 	host_as<Rendered> ().self_illumination = 0.0f;
 
 	auto sound = host_as<AmbientHacked> ();
@@ -170,15 +226,67 @@ KDSnuffable::off_common ()
 	GenericMessage ("TurnOff").broadcast (host (), "~ParticleAttachement");
 
 	if (!relight_on_frob)
-		host ().add_metaprop (Object ("FrobInert"));
+		host ().add_metaprop (KDHandles::get_object ("FrobInert"));
 }
 
 Message::Result
 KDSnuffable::toggle (Message& message)
 {
-	if (host_as<AnimLight> ().light_mode == on_mode)
-		return turn_off (message);
+	KD_PROFILE_MESSAGE (message);
+	request (!is_lit ());
+	return Message::HALT;
+}
+
+bool
+KDSnuffable::is_lit ()
+{
+	// A pending request counts as already applied.
+	return request_pending ? bool (requested_on)
+		: host_as<AnimLight> ().light_mode == on_mode;
+}
+
+void
+KDSnuffable::request (bool on)
+{
+	if (!request_pending)
+		GenericMessage ("SnuffBatch").post (host (), host ());
+	request_pending = true;
+	requested_on = on;
+}
+
+Message::Result
+KDSnuffable::on_batch (Message& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (!request_pending) return Message::HALT;
+	request_pending = false;
+	if (requested_on)
+		light ();
 	else
-		return turn_on (message);
+		snuff ();
+	return Message::HALT;
+}
+
+Message::Result
+KDSnuffable::on_group (Message& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	String name = message.get_name (), group = snuff_group;
+	if (group.empty ())
+	{
+		log (Log::WARNING, "Received %|| without a snuff_group.", name);
+		return Message::ERROR;
+	}
+
+	// A group toggle follows the state of the light that received it.
+	bool on = (name == "GroupTurnOn") ||
+		(name == "GroupToggle" && !is_lit ());
+
+	auto range = groups.equal_range (group);
+	for (auto member = range.first; member != range.second; ++member)
+		GenericMessage (on ? "TurnOn" : "TurnOff").send
+			(host (), Object (member->second));
+
+	return Message::HALT;
 }
 
@@ -21,8 +21,8 @@
 #ifndef KDSNUFFABLE_HH
 #define KDSNUFFABLE_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDHandles.hh"
+#include <map>
 
 class KDSnuffable : public Script
 {
@@ -31,19 +31,39 @@ public:
 
 private:
 	virtual void initialize ();
+	virtual void deinitialize ();
 	Message::Result on_post_sim (Message&);
 
 	Message::Result turn_on (Message&);
+	void light ();
 	void on_common ();
 
 	Message::Result turn_off (Message&);
+	void snuff ();
 	void off_common ();
 
 	Message::Result toggle (Message&);
 
+	// Requests are gathered until the next message cycle, so that several
+	// stimuli in one frame change the light only once. Until then, the
+	// light reports the requested state as its own, so that a toggle
+	// undoes an earlier request instead of repeating it. The request is
+	// saved with the game, and its batch is posted again on load.
+	bool is_lit ();
+	void request (bool on);
+	Message::Result on_batch (Message&);
+	Persistent<bool> request_pending, requested_on;
+
+	Message::Result on_group (Message&);
+
+	typedef std::multimap<String, Object::Number> Groups;
+	static Groups groups;
+
 	Persistent<AnimLight::Mode> on_mode, off_mode;
 	Parameter<bool> relight_on_frob;
 	Parameter<Object> light_on_schema, light_off_schema;
+	Parameter<String> snuff_group;
+	String registered_group;
 };
 
 #endif // KDSNUFFABLE_HH
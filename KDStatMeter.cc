@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDStatMeter.hh"
+#include "KDProfile.hh"
 
 
 
@@ -75,6 +76,10 @@ KDStatMeter::KDStatMeter (const String& _name, const Object& _host)
 	  THIEF_PARAMETER_FULL (low, "stat_range_low", 25),
 	  THIEF_PARAMETER_FULL (high, "stat_range_high", 75),
 
+	  text_watch ({ &_text, &quest_var, &prop_obj }),
+	  range_watch ({ &_min, &_max, &quest_var, &prop_name, &prop_field,
+		&prop_obj }),
+
 	  THIEF_PARAMETER_FULL (color_bg, "stat_color_bg", Color (0x000000)),
 	  THIEF_PARAMETER_FULL (color_low, "stat_color_low", Color (0x0000ff)),
 	  THIEF_PARAMETER_FULL (color_med, "stat_color_med", Color (0x00ffff)),
@@ -103,7 +108,9 @@ KDStatMeter::initialize ()
 		enabled = Parameter<bool> (host (), "stat_meter", true);
 
 	ObjectProperty::subscribe ("DesignNote", host ());
+	text_watch.check ();
 	update_text ();
+	range_watch.check ();
 	update_range ();
 }
 
@@ -118,7 +125,7 @@ KDStatMeter::deinitialize ()
 
 
 bool
-KDStatMeter::prepare ()
+KDStatMeter::prepare_element ()
 {
 	if (!enabled) return false;
 
@@ -248,7 +255,7 @@ KDStatMeter::prepare ()
 }
 
 void
-KDStatMeter::redraw ()
+KDStatMeter::redraw_element ()
 {
 	// Calculate value-sensitive colors.
 	Color tier_color, color_blend = (value_pct < 0.5f)
@@ -374,8 +381,9 @@ KDStatMeter::get_request_size () const
 
 
 Message::Result
-KDStatMeter::on_post_sim (Message&)
+KDStatMeter::on_post_sim (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Update anything based on an object that may have been absent.
 
 	schedule_redraw ();
@@ -424,16 +432,18 @@ KDStatMeter::on_post_sim (Message&)
 
 
 Message::Result
-KDStatMeter::on_on (Message&)
+KDStatMeter::on_on (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	enabled = true;
 	return Message::HALT;
 }
 
 
 Message::Result
-KDStatMeter::on_off (Message&)
+KDStatMeter::on_off (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	enabled = false;
 	return Message::HALT;
 }
@@ -443,13 +453,17 @@ KDStatMeter::on_off (Message&)
 Message::Result
 KDStatMeter::on_property_change (PropertyMessage& message)
 {
-	if (message.property == Property ("DesignNote"))
+	KD_PROFILE_MESSAGE (message);
+	if (message.property == KDHandles::get_property ("DesignNote"))
 	{
 		// Too many to check, so just assume the meter is affected.
 		schedule_redraw ();
 
-		update_text ();
-		update_range ();
+		// Only rederive the text and range if their sources changed.
+		if (text_watch.check ())
+			update_text ();
+		if (range_watch.check ())
+			update_range ();
 	}
 	return Message::HALT;
 }
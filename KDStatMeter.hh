@@ -22,6 +22,8 @@
 #define KDSTATMETER_HH
 
 #include "KDHUDElement.hh"
+#include "KDHandles.hh"
+#include "KDParameterWatch.hh"
 
 class KDStatMeter : public Script, public KDHUDElement
 {
@@ -37,8 +39,8 @@ private:
 	virtual void initialize ();
 	virtual void deinitialize ();
 
-	virtual bool prepare ();
-	virtual void redraw ();
+	virtual bool prepare_element ();
+	virtual void redraw_element ();
 
 	CanvasSize get_request_size () const;
 
@@ -74,6 +76,8 @@ private:
 	Parameter<float> _min, _max; float min, max;
 	Parameter<int> low, high;
 
+	KDParameterWatch text_watch, range_watch;
+
 	Parameter<Color> color_bg, color_low, color_med, color_high;
 
 	// temporary data
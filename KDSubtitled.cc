@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDSubtitled.hh"
+#include "KDProfile.hh"
 
 
 
@@ -50,6 +51,7 @@ HUDSubtitle::~HUDSubtitle ()
 bool
 HUDSubtitle::prepare ()
 {
+	KD_PROFILE ();
 	// Get the canvas and text size and calculate the element size.
 	CanvasSize canvas = Engine::get_canvas_size (),
 		text_size = get_text_size (text),
@@ -82,6 +84,7 @@ HUDSubtitle::prepare ()
 void
 HUDSubtitle::redraw ()
 {
+	KD_PROFILE ();
 	// draw background
 	set_drawing_color (BACKGROUND_COLOR);
 	fill_area ();
@@ -190,6 +193,7 @@ KDSubtitled::finish_subtitle (const SoundSchema& schema)
 Message::Result
 KDSubtitled::on_subtitle (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	SoundSchema schema = message.get_data (Message::DATA1, Object ());
 	Being speaker = message.get_data (Message::DATA2, message.get_from ());
 	start_subtitle (speaker, schema);
@@ -199,6 +203,7 @@ KDSubtitled::on_subtitle (Message& message)
 Message::Result
 KDSubtitled::on_finish_subtitle (TimerMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	finish_subtitle (message.get_data (Message::DATA1, Object ()));
 	return Message::HALT;
 }
@@ -230,10 +235,12 @@ KDSubtitledAI::deinitialize ()
 Message::Result
 KDSubtitledAI::on_property_change (PropertyMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	AI ai = host_as<AI> ();
 
 	// Confirm that the relevant property has changed.
-	if (message.object != ai || message.property != Property ("Speech"))
+	if (message.object != ai ||
+	    message.property != KDHandles::get_property ("Speech"))
 		return Message::HALT;
 
 	// Confirm that the speech schema is valid.
@@ -271,8 +278,9 @@ KDSubtitledVO::KDSubtitledVO (const String& _name, const Object& _host)
 }
 
 Message::Result
-KDSubtitledVO::on_turn_on (Message&)
+KDSubtitledVO::on_turn_on (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Identify the schema.
 	SoundSchema schema =
 		Link::get_one ("SoundDescription", host ()).get_dest ();
@@ -303,6 +311,7 @@ KDSubtitledVO::on_turn_on (Message&)
 Message::Result
 KDSubtitledVO::on_initial_delay (TimerMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	// Display the subtitle.
 	start_subtitle (Player (),
 		message.get_data (Message::DATA1, Object ()));
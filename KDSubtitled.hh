@@ -21,9 +21,7 @@
 #ifndef KDSUBTITLED_HH
 #define KDSUBTITLED_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
-
+#include "KDHandles.hh"
 
 
 class HUDSubtitle : public HUDElement
@@ -19,29 +19,80 @@
  *****************************************************************************/
 
 #include "KDSyncGlobalFog.hh"
+#include "KDProfile.hh"
 
 KDSyncGlobalFog::KDSyncGlobalFog (const String& _name, const Object& _host)
 	: Script (_name, _host),
 	  transition (*this, &KDSyncGlobalFog::step, "SyncGlobalFog", 50ul,
 		0ul, Curve::LINEAR, "transition", "curve"),
+	  step_filter (host ()),
+	  last_fog (),
 	  THIEF_PARAMETER (sync_fog_color, true),
 	  THIEF_PARAMETER (sync_fog_dist, true),
 	  THIEF_PARAMETER (sync_fog_disabled, false),
 	  THIEF_PARAMETER (fog_dist_mult, 1.0f),
 	  THIEF_PARAMETER (fog_dist_add, 0.0f),
 	  THIEF_PERSISTENT (last_room_zone),
-	  THIEF_PERSISTENT (start_color),
-	  THIEF_PERSISTENT (end_color),
-	  THIEF_PERSISTENT (start_distance),
-	  THIEF_PERSISTENT (end_distance)
+	  state (*this, "state", 1u),
+	  zone_fogs_known (false)
 {
+	listen_message ("Sim", &KDSyncGlobalFog::on_sim);
 	listen_message ("ObjRoomTransit", &KDSyncGlobalFog::on_room_transit);
 	listen_message ("FogZoneChange", &KDSyncGlobalFog::on_fog_zone_change);
 }
 
 void
-KDSyncGlobalFog::sync (const Color& color, float distance, bool sync_color,
-	bool sync_distance)
+KDSyncGlobalFog::initialize ()
+{
+	Script::initialize ();
+
+	KDEnvScheduler::attach ();
+
+	// A game may have been loaded, so reread the fog zones. The zone fogs
+	// may have been changed by other means since they were last read.
+	room_zones.clear ();
+	zone_fogs_known = false;
+	get_zone_fog (Fog::GLOBAL);
+}
+
+void
+KDSyncGlobalFog::deinitialize ()
+{
+	KDEnvScheduler::detach ();
+	Script::deinitialize ();
+}
+
+Fog::Zone
+KDSyncGlobalFog::get_room_zone (const Room& room)
+{
+	// A room's fog zone is fixed in the mission, so it is read only on the
+	// player's first transit into the room.
+	auto cached = room_zones.find (room.number);
+	if (cached != room_zones.end ())
+		return cached->second;
+
+	Fog::Zone zone = room.fog_zone;
+	room_zones.insert (std::make_pair (room.number, zone));
+	return zone;
+}
+
+Fog&
+KDSyncGlobalFog::get_zone_fog (Fog::Zone zone)
+{
+	// The zone fogs are read together, then kept current by FogZoneChange
+	// from KDTrapFog. Nothing else sends it, so see the note on zone_fogs.
+	if (!zone_fogs_known)
+	{
+		for (int each = Fog::GLOBAL; each <= Fog::_MAX_ZONE; ++each)
+			zone_fogs [each] = Mission::get_fog (Fog::Zone (each));
+		zone_fogs_known = true;
+	}
+	return zone_fogs [zone];
+}
+
+void
+KDSyncGlobalFog::sync (Time now, const Color& color, float distance,
+	bool sync_color, bool sync_distance)
 {
 	Fog global = Mission::get_fog (Fog::GLOBAL);
 
@@ -52,37 +103,85 @@ KDSyncGlobalFog::sync (const Color& color, float distance, bool sync_color,
 	sync_distance = (sync_distance && sync_fog_dist && distance >= 0.0f)
 		|| global.distance == 0.0f || distance == 0.0f;
 
-	start_color = global.color;
-	end_color = sync_color ? color : global.color;
+	State _state;
+	_state.start_color = global.color;
+	_state.end_color = sync_color ? color : global.color;
 
-	start_distance = global.distance;
-	end_distance = sync_distance ? distance : global.distance;
+	_state.start_distance = global.distance;
+	_state.end_distance = sync_distance ? distance : global.distance;
+
+	_state.start_time = now;
+	state.set (_state);
 
 	log (Log::NORMAL, "Synchronizing global fog to color %|| at distance "
-		"%|| over %|| ms.", end_color, end_distance, transition.length);
+		"%|| over %|| ms.", _state.end_color, _state.end_distance,
+		transition.length);
+	KDEnvScheduler::hold (Fog::GLOBAL, host (), now);
+	step_filter.reset ();
 	transition.start ();
 }
 
 bool
 KDSyncGlobalFog::step ()
 {
-	Mission::set_fog (Fog::GLOBAL, {
-		transition.interpolate (start_color, end_color),
-		Fog::interpolate_distance (true, start_distance, end_distance,
+	KD_PROFILE ();
+	// Stop if the transition's state is lost, as from an older save.
+	State _state;
+	if (!state.get (_state))
+	{
+		KDEnvScheduler::release (Fog::GLOBAL, host ());
+		return false;
+	}
+
+	// Stop if a later transition has taken over the global fog.
+	if (!KDEnvScheduler::hold (Fog::GLOBAL, host (), _state.start_time))
+	{
+		log (Log::VERBOSE, "Global fog synchronization superseded.");
+		return false;
+	}
+
+	Fog fog {
+		transition.interpolate (_state.start_color, _state.end_color),
+		Fog::interpolate_distance (true,
+			_state.start_distance, _state.end_distance,
 			transition.get_progress (), transition.curve)
-	});
+	};
+
+	// Skip any step that wouldn't make a noticeable difference.
+	if (step_filter.admit (transition,
+			KDEnvStepFilter::get_change (last_fog, fog)))
+	{
+		Mission::set_fog (Fog::GLOBAL, fog);
+		last_fog = fog;
+	}
+
+	if (transition.get_progress () >= 1.0f)
+		KDEnvScheduler::release (Fog::GLOBAL, host ());
 	return true;
 }
 
+Message::Result
+KDSyncGlobalFog::on_sim (SimMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (message.event == SimMessage::START)
+	{
+		zone_fogs_known = false;
+		get_zone_fog (Fog::GLOBAL);
+	}
+	return Message::HALT;
+}
+
 Message::Result
 KDSyncGlobalFog::on_room_transit (RoomMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (message.object_type != RoomMessage::PLAYER)
 		return Message::HALT; // The starting point is still our host.
 	if (message.to_room == Object::NONE)
 		return Message::HALT; // This is not a valid transit message.
 
-	Fog::Zone new_zone = message.to_room.fog_zone;
+	Fog::Zone new_zone = get_room_zone (message.to_room);
 	if (last_room_zone.exists () && last_room_zone == new_zone)
 		return Message::HALT; // no change
 
@@ -98,7 +197,7 @@ KDSyncGlobalFog::on_room_transit (RoomMessage& message)
 	}
 	else if (new_zone > Fog::GLOBAL && new_zone <= Fog::_MAX_ZONE)
 	{
-		Fog zone_fog = Mission::get_fog (new_zone);
+		const Fog& zone_fog = get_zone_fog (new_zone);
 		color = zone_fog.color;
 		distance = zone_fog.distance;
 		sync_color = true;
@@ -107,13 +206,14 @@ KDSyncGlobalFog::on_room_transit (RoomMessage& message)
 		return Message::HALT; // invalid zone
 
 	last_room_zone = new_zone;
-	sync (color, distance, sync_color);
+	sync (message.get_time (), color, distance, sync_color);
 	return Message::HALT;
 }
 
 Message::Result
 KDSyncGlobalFog::on_fog_zone_change (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (!message.has_data (Message::DATA1) ||
 	    !message.has_data (Message::DATA2) ||
 	    !message.has_data (Message::DATA3))
@@ -123,8 +223,15 @@ KDSyncGlobalFog::on_fog_zone_change (Message& message)
 	Color color = message.get_data<Color> (Message::DATA2);
 	float distance = message.get_data<float> (Message::DATA3);
 
+	if (changed_zone >= Fog::GLOBAL && changed_zone <= Fog::_MAX_ZONE)
+	{
+		Fog& zone_fog = get_zone_fog (changed_zone);
+		zone_fog.color = color;
+		zone_fog.distance = distance;
+	}
+
 	if (last_room_zone.exists () && last_room_zone == changed_zone)
-		sync (color, distance);
+		sync (message.get_time (), color, distance);
 
 	return Message::HALT;
 }
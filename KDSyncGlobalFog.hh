@@ -21,8 +21,10 @@
 #ifndef KDSYNCGLOBALFOG_HH
 #define KDSYNCGLOBALFOG_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDEnvScheduler.hh"
+#include "KDEnvStepFilter.hh"
+#include "KDPackedState.hh"
+#include <map>
 
 class KDSyncGlobalFog : public Script
 {
@@ -30,13 +32,22 @@ public:
 	KDSyncGlobalFog (const String& name, const Object& host);
 
 private:
-	void sync (const Color& color, float distance, bool sync_color = true,
-		bool sync_distance = true);
+	virtual void initialize ();
+	virtual void deinitialize ();
+
+	Fog::Zone get_room_zone (const Room& room);
+	Fog& get_zone_fog (Fog::Zone zone);
+
+	void sync (Time now, const Color& color, float distance,
+		bool sync_color = true, bool sync_distance = true);
 
 	bool step ();
 
 	Transition transition;
+	KDEnvStepFilter step_filter;
+	Fog last_fog;
 
+	Message::Result on_sim (SimMessage&);
 	Message::Result on_room_transit (RoomMessage&);
 	Message::Result on_fog_zone_change (Message&);
 
@@ -44,8 +55,24 @@ private:
 	Parameter<float> fog_dist_mult, fog_dist_add;
 
 	Persistent<Fog::Zone> last_room_zone;
-	Persistent<Color> start_color, end_color;
-	Persistent<float> start_distance, end_distance;
+
+	struct State
+	{
+		Color start_color, end_color;
+		float start_distance, end_distance;
+		Time start_time;
+	};
+	KDPackedState<State> state;
+
+	typedef std::map<Object::Number, Fog::Zone> RoomZones;
+	RoomZones room_zones;
+
+	// The zone fogs are read when the simulation starts or a game is
+	// loaded. After that, only changes made by KDTrapFog, which sends
+	// FogZoneChange, are seen. A zone fog changed by any other means is
+	// not synchronized until the next load.
+	Fog zone_fogs [Fog::_MAX_ZONE + 1];
+	bool zone_fogs_known;
 };
 
 #endif // KDSYNCGLOBALFOG_HH
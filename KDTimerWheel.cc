@@ -0,0 +1,69 @@
+/******************************************************************************
+ *  KDTimerWheel.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDTimerWheel.hh"
+
+const Time
+KDTimerWheel::SLOT_LENGTH = 50ul;
+
+const Time
+KDTimerWheel::MAX_PHASE = 2000ul;
+
+const unsigned
+KDTimerWheel::SLOT_CAPACITY = 4u;
+
+unsigned long
+KDTimerWheel::current_slot = 0ul;
+
+unsigned
+KDTimerWheel::current_load = 0u;
+
+Time
+KDTimerWheel::get_phase (const Object& host, Time period)
+{
+	unsigned long range = std::min (static_cast<unsigned long> (period),
+		static_cast<unsigned long> (MAX_PHASE));
+	unsigned long slots = range / static_cast<unsigned long> (SLOT_LENGTH);
+	if (slots == 0ul) return 0ul;
+
+	// A multiplicative hash scatters neighboring object numbers across the
+	// slots, while keeping each host's phase the same from run to run.
+	unsigned long hash = static_cast<unsigned long> (host.number) *
+		2654435761ul;
+	return Time ((hash % slots) * static_cast<unsigned long> (SLOT_LENGTH));
+}
+
+bool
+KDTimerWheel::admit (Time now)
+{
+	unsigned long slot = static_cast<unsigned long> (now) /
+		static_cast<unsigned long> (SLOT_LENGTH);
+	if (slot != current_slot)
+	{
+		current_slot = slot;
+		current_load = 0u;
+	}
+
+	if (current_load >= SLOT_CAPACITY)
+		return false;
+
+	++current_load;
+	return true;
+}
@@ -0,0 +1,46 @@
+/******************************************************************************
+ *  KDTimerWheel.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDTIMERWHEEL_HH
+#define KDTIMERWHEEL_HH
+
+#include <Thief/Thief.hh>
+using namespace Thief;
+
+// Spreads periodic script work across frames. Each host is given a fixed
+// phase offset for its periodic timer, and only a limited number of periodic
+// callbacks are admitted per time slot. Callbacks that are not admitted
+// should retry after SLOT_LENGTH, rolling them over to the next slot.
+class KDTimerWheel
+{
+public:
+	static const Time SLOT_LENGTH;
+	static const Time MAX_PHASE;
+	static const unsigned SLOT_CAPACITY;
+
+	static Time get_phase (const Object& host, Time period);
+	static bool admit (Time now);
+
+private:
+	static unsigned long current_slot;
+	static unsigned current_load;
+};
+
+#endif // KDTIMERWHEEL_HH
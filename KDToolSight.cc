@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDToolSight.hh"
+#include "KDProfile.hh"
 
 const HUDElement::ZIndex
 KDToolSight::PRIORITY = 30;
@@ -63,7 +64,7 @@ KDToolSight::deinitialize ()
 }
 
 bool
-KDToolSight::prepare ()
+KDToolSight::prepare_element ()
 {
 	if (!selected) return false;
 	try { if (!when_remote && Camera::is_remote ()) return false; }
@@ -76,7 +77,7 @@ KDToolSight::prepare ()
 }
 
 void
-KDToolSight::redraw ()
+KDToolSight::redraw_element ()
 {
 	set_drawing_color (color);
 	if (image->bitmap)
@@ -86,22 +87,25 @@ KDToolSight::redraw ()
 }
 
 Message::Result
-KDToolSight::on_inv_select (Message&)
+KDToolSight::on_inv_select (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	selected = true;
 	return Message::HALT;
 }
 
 Message::Result
-KDToolSight::on_inv_deselect (Message&)
+KDToolSight::on_inv_deselect (Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	selected = false;
 	return Message::HALT;
 }
 
 Message::Result
-KDToolSight::on_frob_inv_end (FrobMessage&)
+KDToolSight::on_frob_inv_end (FrobMessage& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	if (deselect_on_use)
 		Player ().clear_item ();
 	return Message::HALT;
@@ -110,7 +114,8 @@ KDToolSight::on_frob_inv_end (FrobMessage&)
 Message::Result
 KDToolSight::on_property_change (PropertyMessage& message)
 {
-	if (message.property == Property ("DesignNote"))
+	KD_PROFILE_MESSAGE (message);
+	if (message.property == KDHandles::get_property ("DesignNote"))
 		schedule_redraw ();
 	return Message::HALT;
 }
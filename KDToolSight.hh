@@ -22,6 +22,7 @@
 #define KDTOOLSIGHT_HH
 
 #include "KDHUDElement.hh"
+#include "KDHandles.hh"
 
 class KDToolSight : public Script, public KDHUDElement
 {
@@ -32,8 +33,8 @@ private:
 	virtual void initialize ();
 	virtual void deinitialize ();
 
-	virtual bool prepare ();
-	virtual void redraw ();
+	virtual bool prepare_element ();
+	virtual void redraw_element ();
 
 	Message::Result on_inv_select (Message&);
 	Message::Result on_inv_deselect (Message&);
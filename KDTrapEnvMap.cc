@@ -19,18 +19,33 @@
  *****************************************************************************/
 
 #include "KDTrapEnvMap.hh"
+#include "KDProfile.hh"
+#include <algorithm>
+
+const Time
+KDTrapEnvMap::MIN_INTERVAL = 30ul;
 
 KDTrapEnvMap::KDTrapEnvMap (const String& _name, const Object& _host)
 	: TrapTrigger (_name, _host),
 	  THIEF_PARAMETER (env_map_zone, 0u),
 	  THIEF_PARAMETER (env_map_on),
-	  THIEF_PARAMETER (env_map_off)
-{}
+	  THIEF_PARAMETER (env_map_off),
+	  THIEF_PARAMETER (env_map_spare, -1),
+	  THIEF_PARAMETER (env_map_spare_off, -1),
+	  THIEF_PARAMETER (env_map_sequence),
+	  THIEF_PARAMETER (env_map_interval, 100ul),
+	  THIEF_PERSISTENT_FULL (frame, 0),
+	  THIEF_PERSISTENT_FULL (sequences, 0)
+{
+	listen_message ("PostSim", &KDTrapEnvMap::on_post_sim);
+	listen_timer ("EnvMapFrame", &KDTrapEnvMap::on_frame);
+}
 
 Message::Result
-KDTrapEnvMap::on_trap (bool on, Message&)
+KDTrapEnvMap::on_trap (bool on, Message& message)
 {
-	if (Engine::get_version () < Version (1, 20))
+	KD_PROFILE_MESSAGE (message);
+	if (!is_supported ())
 	{
 		log (Log::ERROR, "This script cannot be used with this version "
 			"of the Dark Engine. Upgrade to NewDark version 1.20 or "
@@ -38,21 +53,141 @@ KDTrapEnvMap::on_trap (bool on, Message&)
 		return Message::ERROR;
 	}
 
-	if (env_map_zone < 0 || env_map_zone >= 64)
+	if (!is_valid_zone (env_map_zone))
 	{
 		log (Log::ERROR, "The environment map zone %|| is invalid. It "
 			"must be between 0 and 63, inclusive.", env_map_zone);
 		return Message::ERROR;
 	}
 
+	// Any trigger ends a sequence started by this trap.
+	sequences = sequences + 1;
+	const std::vector<String>& textures = get_sequence ();
+	if (on && !textures.empty ())
+	{
+		log (Log::NORMAL, "Starting a sequence of %|| textures in "
+			"environment map zone %||.", textures.size (),
+			env_map_zone);
+		frame = 0;
+		start_timer ("EnvMapFrame", 0ul, false, int (sequences));
+		return Message::HALT;
+	}
+
 	const String& texture = on ? env_map_on : env_map_off;
 	if (!texture.empty ())
 	{
 		log (Log::NORMAL, "Setting environment map zone %|| to "
 			"texture %||.", env_map_zone, texture);
-		Mission::set_envmap_texture (env_map_zone, texture);
+		set_texture (texture, on ? env_map_off : env_map_on);
 	}
 
 	return Message::HALT;
 }
 
+Message::Result
+KDTrapEnvMap::on_post_sim (Message& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	// Load the textures for the first triggers ahead of time. The off
+	// texture needs a second spare zone, as one zone holds one texture.
+	if (is_supported ())
+	{
+		const std::vector<String>& textures = get_sequence ();
+		prefetch (textures.empty () ? env_map_on : textures.front (),
+			env_map_spare);
+		prefetch (env_map_off, env_map_spare_off);
+	}
+	return Message::CONTINUE;
+}
+
+Message::Result
+KDTrapEnvMap::on_frame (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (message.get_data (Message::DATA1, 0) != sequences)
+		return Message::HALT; // It was ended or restarted since.
+
+	const std::vector<String>& textures = get_sequence ();
+	if (textures.empty ())
+		return Message::HALT;
+
+	size_t current = size_t (frame) % textures.size ();
+	set_texture (textures [current],
+		textures [(current + 1) % textures.size ()]);
+	frame = (current + 1) % textures.size ();
+
+	// Swapping more often than this would only keep the timer busy.
+	Time interval = std::max
+		(static_cast<unsigned long> (Time (env_map_interval)),
+		 static_cast<unsigned long> (MIN_INTERVAL));
+	start_timer ("EnvMapFrame", interval, false, int (sequences));
+	return Message::HALT;
+}
+
+bool
+KDTrapEnvMap::is_supported ()
+{
+	return Engine::get_version () >= Version (1, 20);
+}
+
+bool
+KDTrapEnvMap::is_valid_zone (int zone)
+{
+	return zone >= 0 && zone < 64;
+}
+
+void
+KDTrapEnvMap::set_texture (const String& texture, const String& next)
+{
+	Mission::set_envmap_texture (env_map_zone, texture);
+
+	// With a second spare zone, the on and off textures both stay loaded
+	// from PostSim, so the first spare zone is left alone.
+	if (!env_map_spare_off.exists () || !get_sequence ().empty ())
+		prefetch (next, env_map_spare);
+}
+
+void
+KDTrapEnvMap::prefetch (const String& texture, const Parameter<int>& spare)
+{
+	// Binding a texture to a spare zone, one no room uses, loads it without
+	// showing it, so that the next swap does not wait on the load.
+	if (texture.empty () || !spare.exists () ||
+	    int (spare) == int (env_map_zone))
+		return;
+
+	if (!is_valid_zone (spare))
+	{
+		log (Log::WARNING, "The spare environment map zone %|| is "
+			"invalid. It must be between 0 and 63, inclusive.",
+			spare);
+		return;
+	}
+
+	log (Log::VERBOSE, "Prefetching texture %|| in environment map zone "
+		"%||.", texture, spare);
+	Mission::set_envmap_texture (spare, texture);
+}
+
+// The sequence is a list of textures separated by "|".
+const std::vector<String>&
+KDTrapEnvMap::get_sequence ()
+{
+	const String& raw = env_map_sequence;
+	if (raw != sequence_raw)
+	{
+		sequence.clear ();
+		size_t start = 0u, end;
+		do
+		{
+			end = raw.find ('|', start);
+			String texture = raw.substr (start, end - start);
+			if (!texture.empty ())
+				sequence.push_back (texture);
+			start = end + 1u;
+		}
+		while (end != String::npos);
+		sequence_raw = raw;
+	}
+	return sequence;
+}
@@ -22,6 +22,7 @@
 #define KDTRAPENVMAP_HH
 
 #include <Thief/Thief.hh>
+#include <vector>
 using namespace Thief;
 
 class KDTrapEnvMap : public TrapTrigger
@@ -31,9 +32,27 @@ public:
 
 private:
 	virtual Message::Result on_trap (bool on, Message&);
+	Message::Result on_post_sim (Message&);
+	Message::Result on_frame (TimerMessage&);
+
+	bool is_supported ();
+	bool is_valid_zone (int zone);
+	void set_texture (const String& texture, const String& next);
+	void prefetch (const String& texture, const Parameter<int>& spare);
+
+	const std::vector<String>& get_sequence ();
 
 	Parameter<int> env_map_zone;
 	Parameter<String> env_map_on, env_map_off;
+	Parameter<int> env_map_spare, env_map_spare_off;
+
+	static const Time MIN_INTERVAL;
+	Parameter<String> env_map_sequence;
+	Parameter<Time> env_map_interval;
+	Persistent<int> frame, sequences;
+
+	String sequence_raw;
+	std::vector<String> sequence;
 };
 
 #endif // KDTRAPENVMAP_HH
@@ -19,25 +19,40 @@
  *****************************************************************************/
 
 #include "KDTrapFog.hh"
+#include "KDProfile.hh"
 
 KDTrapFog::KDTrapFog (const String& _name, const Object& _host)
 	: TrapTrigger (_name, _host),
 	  transition (*this, &KDTrapFog::step, "Fog", 50ul,
 		0ul, Curve::LINEAR, "transition", "curve"),
+	  step_filter (host ()),
+	  last_fog (),
 	  THIEF_PARAMETER (fog_zone, Fog::GLOBAL),
 	  THIEF_PARAMETER (fog_color_on),
 	  THIEF_PARAMETER (fog_color_off),
 	  THIEF_PARAMETER (fog_dist_on, -1.0f),
 	  THIEF_PARAMETER (fog_dist_off, -1.0f),
-	  THIEF_PERSISTENT (start_color),
-	  THIEF_PERSISTENT (end_color),
-	  THIEF_PERSISTENT (start_distance),
-	  THIEF_PERSISTENT (end_distance)
+	  state (*this, "state", 1u)
 {}
 
+void
+KDTrapFog::initialize ()
+{
+	TrapTrigger::initialize ();
+	KDEnvScheduler::attach ();
+}
+
+void
+KDTrapFog::deinitialize ()
+{
+	KDEnvScheduler::detach ();
+	TrapTrigger::deinitialize ();
+}
+
 Message::Result
-KDTrapFog::on_trap (bool on, Message&)
+KDTrapFog::on_trap (bool on, Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	Color _end_color = on ? fog_color_on : fog_color_off;
 	float _end_distance = on ? fog_dist_on : fog_dist_off;
 
@@ -46,20 +61,27 @@ KDTrapFog::on_trap (bool on, Message&)
 		return Message::HALT;
 
 	Fog current = Mission::get_fog (fog_zone);
-	start_color = current.color;
-	start_distance = current.distance;
-	end_color = (_end_color != Color ()) ? _end_color : start_color;
-	end_distance = (_end_distance >= 0.0f) ? _end_distance : start_distance;
+	State _state;
+	_state.start_color = current.color;
+	_state.start_distance = current.distance;
+	_state.end_color = (_end_color != Color ())
+		? _end_color : current.color;
+	_state.end_distance = (_end_distance >= 0.0f)
+		? _end_distance : current.distance;
+	_state.start_time = message.get_time ();
+	state.set (_state);
 
 	// Notify the Player object in case KDSyncGlobalFog is present.
-	GenericMessage::with_data ("FogZoneChange",
-		Fog::Zone (fog_zone), Color (end_color), float (end_distance))
+	GenericMessage::with_data ("FogZoneChange", Fog::Zone (fog_zone),
+		_state.end_color, _state.end_distance)
 			.send (host (), Player ());
 
 	log (Log::NORMAL, "Starting fog transition for zone %|| from color %|| "
 		"at distance %|| to color %|| at distance %|| over %|| ms.",
-		int (fog_zone), start_color, start_distance, end_color,
-		end_distance, transition.length);
+		int (fog_zone), _state.start_color, _state.start_distance,
+		_state.end_color, _state.end_distance, transition.length);
+	KDEnvScheduler::hold (int (fog_zone), host (), _state.start_time);
+	step_filter.reset ();
 	transition.start ();
 	return Message::HALT;
 }
@@ -67,12 +89,40 @@ KDTrapFog::on_trap (bool on, Message&)
 bool
 KDTrapFog::step ()
 {
-	Mission::set_fog (fog_zone, Fog {
-		transition.interpolate (start_color, end_color),
+	KD_PROFILE ();
+	// Stop if the transition's state is lost, as from an older save.
+	State _state;
+	if (!state.get (_state))
+	{
+		KDEnvScheduler::release (int (fog_zone), host ());
+		return false;
+	}
+
+	// Stop if a later transition has taken over this fog zone.
+	if (!KDEnvScheduler::hold (int (fog_zone), host (), _state.start_time))
+	{
+		log (Log::VERBOSE, "Fog transition for zone %|| superseded.",
+			int (fog_zone));
+		return false;
+	}
+
+	Fog fog {
+		transition.interpolate (_state.start_color, _state.end_color),
 		Fog::interpolate_distance (fog_zone == Fog::GLOBAL,
-			start_distance, end_distance,
+			_state.start_distance, _state.end_distance,
 			transition.get_progress (), transition.curve)
-	});
+	};
+
+	// Skip any step that wouldn't make a noticeable difference.
+	if (step_filter.admit (transition,
+			KDEnvStepFilter::get_change (last_fog, fog)))
+	{
+		Mission::set_fog (fog_zone, fog);
+		last_fog = fog;
+	}
+
+	if (transition.get_progress () >= 1.0f)
+		KDEnvScheduler::release (int (fog_zone), host ());
 	return true;
 }
 
@@ -21,8 +21,9 @@
 #ifndef KDTRAPFOG_HH
 #define KDTRAPFOG_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDEnvScheduler.hh"
+#include "KDEnvStepFilter.hh"
+#include "KDPackedState.hh"
 
 class KDTrapFog : public TrapTrigger
 {
@@ -30,17 +31,27 @@ public:
 	KDTrapFog (const String& name, const Object& host);
 
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
 	virtual Message::Result on_trap (bool on, Message&);
 	bool step ();
 
 	Transition transition;
+	KDEnvStepFilter step_filter;
+	Fog last_fog;
 
 	Parameter<Fog::Zone> fog_zone;
 	Parameter<Color> fog_color_on, fog_color_off;
 	Parameter<float> fog_dist_on, fog_dist_off;
 
-	Persistent<Color> start_color, end_color;
-	Persistent<float> start_distance, end_distance;
+	struct State
+	{
+		Color start_color, end_color;
+		float start_distance, end_distance;
+		Time start_time;
+	};
+	KDPackedState<State> state;
 };
 
 #endif // KDTRAPFOG_HH
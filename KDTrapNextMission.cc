@@ -19,6 +19,7 @@
  *****************************************************************************/
 
 #include "KDTrapNextMission.hh"
+#include "KDProfile.hh"
 
 KDTrapNextMission::KDTrapNextMission (const String& _name, const Object& _host)
 	: TrapTrigger (_name, _host),
@@ -27,8 +28,9 @@ KDTrapNextMission::KDTrapNextMission (const String& _name, const Object& _host)
 {}
 
 Message::Result
-KDTrapNextMission::on_trap (bool on, Message&)
+KDTrapNextMission::on_trap (bool on, Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	int next_mission = on ? next_mission_on : next_mission_off;
 	if (next_mission < 1) return Message::HALT;
 
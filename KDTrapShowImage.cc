@@ -19,20 +19,42 @@
  *****************************************************************************/
 
 #include "KDTrapShowImage.hh"
+#include "KDProfile.hh"
 
 const HUDElement::ZIndex
 KDTrapShowImage::PRIORITY = 50;
 
+const size_t
+KDTrapShowImage::CACHE_SIZE = 4u;
+
+KDTrapShowImage::Cache
+KDTrapShowImage::cache;
+
+size_t
+KDTrapShowImage::instances = 0u;
+
 KDTrapShowImage::KDTrapShowImage (const String& _name, const Object& _host)
 	: TrapTrigger (_name, _host, THIEF_DEFAULT_LOG_LEVEL, true),
 	  KDHUDElement (PRIORITY),
 	  THIEF_PERSISTENT_FULL (enabled, false),
-	  THIEF_PARAMETER (image, Symbol::NONE, false, false, false),
+	  THIEF_PERSISTENT_FULL (hides, 0),
+	  fade_in (*this, &KDTrapShowImage::step_fade_in, "ImageFadeIn", 50ul,
+		0ul, Curve::LINEAR, "image_fade_in", "image_fade_curve"),
+	  fade_out (*this, &KDTrapShowImage::step_fade_out, "ImageFadeOut",
+		50ul, 0ul, Curve::LINEAR, "image_fade_out", "image_fade_curve"),
+	  THIEF_PERSISTENT_FULL (opacity, 0.0f),
+	  THIEF_PERSISTENT_FULL (fade_start, 0.0f),
+	  frame (-1),
+	  bitmap (nullptr),
+	  bitmap_animated (false),
+	  THIEF_PARAMETER (image),
+	  THIEF_PARAMETER_FULL (grace, "image_grace", 10000ul),
 	  THIEF_PARAMETER_FULL (use_hud, "image_use_hud", true),
 	  THIEF_PARAMETER_FULL (position, "image_position", Position::CENTER),
 	  THIEF_PARAMETER_FULL (offset_x, "image_offset_x", 0),
 	  THIEF_PARAMETER_FULL (offset_y, "image_offset_y", 0)
 {
+	listen_timer ("ReleaseImage", &KDTrapShowImage::on_release_image);
 	listen_message ("PropertyChange", &KDTrapShowImage::on_property_change);
 }
 
@@ -42,21 +64,29 @@ KDTrapShowImage::initialize ()
 	Script::initialize ();
 	KDHUDElement::initialize ();
 	ObjectProperty::subscribe ("DesignNote", host ());
+	++instances;
 }
 
 void
 KDTrapShowImage::deinitialize ()
 {
 	ObjectProperty::unsubscribe ("DesignNote", host ());
+	release_bitmap ();
+	if (instances > 0u && --instances == 0u)
+		cache.clear ();
 	KDHUDElement::deinitialize ();
 	Script::deinitialize ();
 }
 
 bool
-KDTrapShowImage::prepare ()
+KDTrapShowImage::prepare_element ()
 {
-	if (!enabled || !use_hud || !image->bitmap) return false;
-	CanvasSize size = image->bitmap->get_size ();
+	// A game saved before images could fade has no opacity.
+	if (enabled && !opacity.exists ())
+		opacity = 1.0f;
+
+	if (opacity <= 0.0f || !use_hud || !get_bitmap ()) return false;
+	CanvasSize size = bitmap->get_size ();
 	set_position (calculate_position (position, size,
 		CanvasPoint (offset_x, offset_y)));
 	set_size (size);
@@ -64,25 +94,160 @@ KDTrapShowImage::prepare ()
 }
 
 void
-KDTrapShowImage::redraw ()
+KDTrapShowImage::redraw_element ()
 {
-	draw_bitmap (image->bitmap);
+	// With a fade, each frame of the bitmap is a step in its opacity.
+	frame = std::lround (opacity * (bitmap->count_frames () - 1));
+	draw_bitmap (bitmap, frame);
 }
 
 Message::Result
-KDTrapShowImage::on_trap (bool on, Message&)
+KDTrapShowImage::on_trap (bool on, Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
 	enabled = on;
 	if (!use_hud)
-		Interface::show_image (image.get_raw ());
+		Interface::show_image (image);
+	else
+	{
+		if (on && !get_bitmap ())
+			log (Log::ERROR, "Could not load bitmap %||.", image);
+
+		// Without at least two frames, there are no opacity steps to
+		// fade through, so the image is shown or hidden at once.
+		if (bitmap && bitmap_animated && bitmap->count_frames () < 2)
+		{
+			if (on)
+				log (Log::WARNING, "Bitmap %|| has only one "
+					"frame, so it can't fade.", image);
+			set_opacity (on ? 1.0f : 0.0f);
+			if (!on) schedule_release ();
+		}
+		else
+		{
+			fade_start = opacity;
+			(on ? fade_in : fade_out).start ();
+		}
+	}
 	return Message::CONTINUE;
 }
 
+bool
+KDTrapShowImage::step_fade_in ()
+{
+	KD_PROFILE ();
+	if (!enabled) return false; // It was turned off since.
+	set_opacity (fade_in.interpolate (float (fade_start), 1.0f));
+	return true;
+}
+
+bool
+KDTrapShowImage::step_fade_out ()
+{
+	KD_PROFILE ();
+	if (enabled) return false; // It was turned on since.
+	set_opacity (fade_out.interpolate (float (fade_start), 0.0f));
+
+	if (fade_out.get_progress () >= 1.0f)
+		schedule_release ();
+	return true;
+}
+
+void
+KDTrapShowImage::set_opacity (float _opacity)
+{
+	opacity = _opacity;
+
+	// Only redraw if another frame of the bitmap is due. A bitmap that
+	// isn't loaded yet is left to prepare, so a fade out of an image never
+	// shown doesn't load it.
+	int new_frame = bitmap ? int (std::lround
+		(opacity * (bitmap->count_frames () - 1))) : -1;
+	if (new_frame != frame || opacity <= 0.0f)
+		schedule_redraw ();
+}
+
+void
+KDTrapShowImage::schedule_release ()
+{
+	// Keep the bitmap for a while in case it is shown again soon.
+	hides = hides + 1;
+	start_timer ("ReleaseImage", grace, false, int (hides));
+}
+
+Message::Result
+KDTrapShowImage::on_release_image (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (!enabled && message.get_data (Message::DATA1, 0) == hides)
+		release_bitmap ();
+	return Message::HALT;
+}
+
 Message::Result
 KDTrapShowImage::on_property_change (PropertyMessage& message)
 {
-	if (message.property == Property ("DesignNote"))
+	KD_PROFILE_MESSAGE (message);
+	if (message.property == KDHandles::get_property ("DesignNote"))
 		schedule_redraw ();
 	return Message::HALT;
 }
 
+HUDBitmap::Ptr
+KDTrapShowImage::get_bitmap ()
+{
+	// The bitmap is loaded on first use, and again if the path changes.
+	// It is only loaded as an animation of opacity steps if it will fade.
+	String path = image;
+	bool animated = fade_in.length.exists () || fade_out.length.exists ();
+	if (path != bitmap_path || animated != bitmap_animated)
+	{
+		release_bitmap ();
+		bitmap = load_bitmap (path, animated);
+		bitmap_path = path;
+		bitmap_animated = animated;
+	}
+	return bitmap;
+}
+
+void
+KDTrapShowImage::release_bitmap ()
+{
+	if (bitmap)
+		cache_bitmap (bitmap_path, bitmap_animated, bitmap);
+	bitmap = nullptr;
+	bitmap_path.clear ();
+}
+
+HUDBitmap::Ptr
+KDTrapShowImage::load_bitmap (const String& path, bool animated)
+{
+	if (path.empty ()) return nullptr;
+
+	for (auto entry = cache.begin (); entry != cache.end (); ++entry)
+		if (entry->path == path && entry->animated == animated)
+		{
+			HUDBitmap::Ptr cached = entry->bitmap;
+			cache.erase (entry);
+			return cached;
+		}
+
+	return HUDBitmap::load (path, animated);
+}
+
+void
+KDTrapShowImage::cache_bitmap (const String& path, bool animated,
+	HUDBitmap::Ptr loaded)
+{
+	for (auto entry = cache.begin (); entry != cache.end (); ++entry)
+		if (entry->path == path && entry->animated == animated)
+		{
+			cache.erase (entry);
+			break;
+		}
+
+	cache.push_front ({ path, animated, loaded });
+	if (cache.size () > CACHE_SIZE)
+		cache.pop_back ();
+}
+
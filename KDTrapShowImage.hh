@@ -22,6 +22,8 @@
 #define KDTRAPSHOWIMAGE_HH
 
 #include "KDHUDElement.hh"
+#include "KDHandles.hh"
+#include <list>
 
 class KDTrapShowImage : public TrapTrigger, public KDHUDElement
 {
@@ -32,17 +34,56 @@ private:
 	virtual void initialize ();
 	virtual void deinitialize ();
 
-	virtual bool prepare ();
-	virtual void redraw ();
+	virtual bool prepare_element ();
+	virtual void redraw_element ();
 
 	virtual Message::Result on_trap (bool on, Message&);
+	Message::Result on_release_image (TimerMessage&);
 	Message::Result on_property_change (PropertyMessage&);
 
+	bool step_fade_in ();
+	bool step_fade_out ();
+	void set_opacity (float opacity);
+	void schedule_release ();
+
 	static const ZIndex PRIORITY;
 
 	Persistent<bool> enabled;
+	Persistent<int> hides;
+
+	Transition fade_in, fade_out;
+	Persistent<float> opacity, fade_start;
+	int frame;
+
+	HUDBitmap::Ptr get_bitmap ();
+	void release_bitmap ();
+
+	HUDBitmap::Ptr bitmap;
+	String bitmap_path;
+	bool bitmap_animated;
+
+	// Recently released bitmaps are kept loaded in case they are reshown.
+	static HUDBitmap::Ptr load_bitmap (const String& path, bool animated);
+	static void cache_bitmap (const String& path, bool animated,
+		HUDBitmap::Ptr loaded);
+
+	struct CacheEntry
+	{
+		String path;
+		bool animated;
+		HUDBitmap::Ptr bitmap;
+	};
+
+	static const size_t CACHE_SIZE;
+	typedef std::list<CacheEntry> Cache;
+	static Cache cache;
+
+	// The cache is emptied when the last instance goes, such as at the end
+	// of a mission, rather than kept until the module is unloaded.
+	static size_t instances;
 
-	Parameter<Image> image;
+	Parameter<String> image;
+	Parameter<Time> grace;
 	Parameter<bool> use_hud;
 	Parameter<Position> position;
 	Parameter<int> offset_x, offset_y;
@@ -19,46 +19,74 @@
  *****************************************************************************/
 
 #include "KDTrapWeather.hh"
+#include "KDProfile.hh"
+#include <sstream>
+
+const Time
+KDTrapWeather::CYCLE_RESOLUTION = 50ul;
 
 KDTrapWeather::KDTrapWeather (const String& _name, const Object& _host)
 	: TrapTrigger (_name, _host),
 	  transition (*this, &KDTrapWeather::step, "Weather", 50ul,
 		0ul, Curve::LINEAR, "transition", "curve"),
+	  step_filter (host ()),
+	  last_precip (),
 
 	  THIEF_PARAMETER (precip_freq_on, -1.0f),
 	  THIEF_PARAMETER (precip_freq_off, -1.0f),
-	  THIEF_PERSISTENT (start_freq),
-	  THIEF_PERSISTENT (end_freq),
 
 	  THIEF_PARAMETER (precip_speed_on, -1.0f),
 	  THIEF_PARAMETER (precip_speed_off, -1.0f),
-	  THIEF_PERSISTENT (start_speed),
-	  THIEF_PERSISTENT (end_speed),
 
 	  THIEF_PARAMETER (precip_radius_on, -1.0f),
 	  THIEF_PARAMETER (precip_radius_off, -1.0f),
-	  THIEF_PERSISTENT (start_radius),
-	  THIEF_PERSISTENT (end_radius),
 
 	  THIEF_PARAMETER (precip_opacity_on, -1.0f),
 	  THIEF_PARAMETER (precip_opacity_off, -1.0f),
-	  THIEF_PERSISTENT (start_opacity),
-	  THIEF_PERSISTENT (end_opacity),
 
 	  THIEF_PARAMETER (precip_brightness_on, -1.0f),
 	  THIEF_PARAMETER (precip_brightness_off, -1.0f),
-	  THIEF_PERSISTENT (start_brightness),
-	  THIEF_PERSISTENT (end_brightness),
 
 	  THIEF_PARAMETER (precip_wind_on, Vector ()),
 	  THIEF_PARAMETER (precip_wind_off, Vector ()),
-	  THIEF_PERSISTENT (start_wind),
-	  THIEF_PERSISTENT (end_wind)
-{}
+
+	  state (*this, "state", 3u),
+
+	  THIEF_PARAMETER (precip_timeline),
+	  THIEF_PERSISTENT_FULL (cycles, 0)
+{
+	listen_timer ("WeatherCycle", &KDTrapWeather::on_cycle);
+}
+
+void
+KDTrapWeather::initialize ()
+{
+	TrapTrigger::initialize ();
+	KDWeatherStack::attach ();
+}
+
+void
+KDTrapWeather::deinitialize ()
+{
+	KDWeatherStack::detach ();
+	TrapTrigger::deinitialize ();
+}
 
 Message::Result
-KDTrapWeather::on_trap (bool on, Message&)
+KDTrapWeather::on_trap (bool on, Message& message)
 {
+	KD_PROFILE_MESSAGE (message);
+	// Any trigger ends a weather cycle started by this trap.
+	if (precip_timeline.exists ())
+	{
+		cycles = cycles + 1;
+		if (on)
+		{
+			start_cycle (message.get_time ());
+			return Message::HALT;
+		}
+	}
+
 	Parameter<float>
 		&freq = on ? precip_freq_on : precip_freq_off,
 		&speed = on ? precip_speed_on : precip_speed_off,
@@ -67,44 +95,239 @@ KDTrapWeather::on_trap (bool on, Message&)
 		&brightness = on ? precip_brightness_on : precip_brightness_off;
 	Parameter<Vector>& wind = on ? precip_wind_on : precip_wind_off;
 
+	if (!freq.exists () && !speed.exists () && !radius.exists () &&
+	    !opacity.exists () && !brightness.exists () && !wind.exists ())
+		return Message::HALT;
+
+	// Any aspect not given keeps its current value.
 	Precipitation precip = Mission::get_precipitation ();
-	start_freq = precip.frequency;
-	start_speed = precip.speed;
-	start_radius = precip.radius;
-	start_opacity = precip.opacity;
-	start_brightness = precip.brightness;
-	start_wind = precip.wind;
-
-	end_freq = (freq >= 0.0f) ? freq : start_freq;
-	end_speed = (speed >= 0.0f) ? speed : start_speed;
-	end_radius = (radius >= 0.0f) ? radius : start_radius;
-	end_opacity = (opacity >= 0.0f) ? opacity : start_opacity;
-	end_brightness = (brightness >= 0.0f) ? brightness : start_brightness;
-	end_wind = wind.exists () ? Vector (wind) : start_wind;
-
-	if (freq.exists () || speed.exists () || radius.exists () ||
-	    opacity.exists () || brightness.exists () || wind.exists ())
+	State _state;
+	_state.base.read (precip);
+	_state.end.freq = (freq >= 0.0f) ? freq : precip.frequency;
+	_state.end.speed = (speed >= 0.0f) ? speed : precip.speed;
+	_state.end.radius = (radius >= 0.0f) ? radius : precip.radius;
+	_state.end.opacity = (opacity >= 0.0f) ? opacity : precip.opacity;
+	_state.end.brightness = (brightness >= 0.0f)
+		? brightness : precip.brightness;
+	_state.end.wind = wind.exists () ? Vector (wind) : precip.wind;
+	_state.start_time = message.get_time ();
+	_state.cycle = false;
+	state.set (_state);
+
+	log (Log::NORMAL, "Starting weather transition over %|| ms.",
+		transition.length);
+	step_filter.reset ();
+	transition.start ();
+	return Message::HALT;
+}
+
+bool
+KDTrapWeather::step ()
+{
+	KD_PROFILE ();
+
+	// Stop if the transition's state is lost, as from an older save, or if
+	// a cycle has replaced it. The cycle's layer has the same owner and
+	// start time, so this step must not update it.
+	State _state;
+	if (!state.get (_state) || _state.cycle)
+		return false;
+
+	Precipitation current = Mission::get_precipitation (),
+		end = _state.end.apply (current),
+		base = _state.base.apply (current);
+
+	// This trap's layer fades in over the transition. Stop if a later
+	// layer has fully covered it.
+	if (!KDWeatherStack::update (host (), _state.start_time,
+			transition.interpolate (0.0f, 1.0f), end, base))
+	{
+		log (Log::VERBOSE, "Weather transition superseded.");
+		return false;
+	}
+
+	float progress = transition.get_progress ();
+	compose (Engine::get_sim_time (), std::lround (progress *
+		static_cast<unsigned long> (Time (transition.length))),
+		progress >= 1.0f);
+	return true;
+}
+
+void
+KDTrapWeather::compose (Time now, unsigned long elapsed, bool last)
+{
+	// The stack is composed once per tick, by whichever trap steps first,
+	// unless this trap is making its last step. The sim time identifies the
+	// tick, as all traps stepping in it see the same one.
+	Precipitation precip;
+	if (!KDWeatherStack::compose (now, precip, last))
+		return;
+
+	// Skip any step that wouldn't make a noticeable difference.
+	float change = KDEnvStepFilter::get_change (last_precip, precip);
+	if (step_filter.admit (elapsed, change, last))
+	{
+		Mission::set_precipitation (precip);
+		last_precip = precip;
+	}
+}
+
+
+
+void
+KDTrapWeather::start_cycle (Time now)
+{
+	if (!precip_timeline.exists ()) return;
+	const Timeline& timeline = precip_timeline;
+	if (timeline.size () < 2u) return;
+
+	log (Log::NORMAL, "Starting weather cycle of %|| ms.",
+		timeline.back ().time);
+	State _state = State ();
+	_state.start_time = now;
+	_state.cycle = true;
+	_state.base.read (Mission::get_precipitation ());
+	state.set (_state);
+	step_filter.reset ();
+	start_timer ("WeatherCycle", 0ul, false, int (cycles));
+}
+
+Message::Result
+KDTrapWeather::on_cycle (TimerMessage& message)
+{
+	KD_PROFILE_MESSAGE (message);
+	if (message.get_data (Message::DATA1, 0) != cycles)
+		return Message::HALT; // The cycle was ended or restarted since.
+
+	// Find the keyframes on either side of the current point in the cycle.
+	State _state;
+	if (!state.get (_state))
+		return Message::HALT; // The cycle's state is lost.
+
+	// The timeline may have been removed or broken since the cycle began.
+	if (!precip_timeline.exists ())
+		return Message::HALT;
+	const Timeline& timeline = precip_timeline;
+	if (timeline.size () < 2u)
+		return Message::HALT;
+
+	Time start_time = _state.start_time;
+	unsigned long elapsed = static_cast<unsigned long> (message.get_time ())
+		- static_cast<unsigned long> (start_time),
+		period = static_cast<unsigned long> (timeline.back ().time),
+		point = elapsed % period;
+
+	auto next = timeline.begin () + 1;
+	while (static_cast<unsigned long> (next->time) <= point)
+		++next;
+	auto prev = next - 1;
+
+	unsigned long prev_time = static_cast<unsigned long> (prev->time),
+		next_time = static_cast<unsigned long> (next->time);
+	float alpha = float (point - prev_time) / float (next_time - prev_time);
+	Curve curve = transition.curve;
+
+	Precipitation current = Mission::get_precipitation (),
+		precip = current;
+	precip.frequency = interpolate (prev->freq, next->freq, alpha, curve);
+	precip.speed = interpolate (prev->speed, next->speed, alpha, curve);
+	precip.radius = interpolate (prev->radius, next->radius, alpha, curve);
+	precip.opacity = interpolate
+		(prev->opacity, next->opacity, alpha, curve);
+	precip.brightness = interpolate
+		(prev->brightness, next->brightness, alpha, curve);
+	precip.wind = interpolate (prev->wind, next->wind, alpha, curve);
+
+	// The cycle's layer fades in over the transition length, like any
+	// other layer, then stays at full weight. Stop if a later layer has
+	// fully covered it.
+	unsigned long length =
+		static_cast<unsigned long> (Time (transition.length));
+	float weight = (elapsed >= length) ? 1.0f
+		: interpolate (0.0f, 1.0f, float (elapsed) / float (length),
+			curve);
+	if (!KDWeatherStack::update (host (), start_time, weight, precip,
+			_state.base.apply (current)))
 	{
-		log (Log::NORMAL, "Starting weather transition over %|| ms.",
-			transition.length);
-		transition.start ();
+		log (Log::VERBOSE, "Weather cycle superseded.");
+		return Message::HALT;
 	}
+	compose (message.get_time (), elapsed, false);
 
+	start_timer ("WeatherCycle", CYCLE_RESOLUTION, false, int (cycles));
 	return Message::HALT;
 }
 
+
+
+// KDTrapWeather::Aspects
+
+void
+KDTrapWeather::Aspects::read (const Precipitation& precip)
+{
+	freq = precip.frequency;
+	speed = precip.speed;
+	radius = precip.radius;
+	opacity = precip.opacity;
+	brightness = precip.brightness;
+	wind = precip.wind;
+}
+
+Precipitation
+KDTrapWeather::Aspects::apply (Precipitation precip) const
+{
+	precip.frequency = freq;
+	precip.speed = speed;
+	precip.radius = radius;
+	precip.opacity = opacity;
+	precip.brightness = brightness;
+	precip.wind = wind;
+	return precip;
+}
+
+
+
+// KDTrapWeather::Timeline
+
+namespace Thief {
+
+// A timeline is a list of keyframes separated by "|". Each keyframe has nine
+// numbers: its time in ms, then the frequency, speed, radius, opacity and
+// brightness of the precipitation, then the X, Y and Z of its wind. The first
+// keyframe must be at time 0, and the last one's time is the cycle's length.
+template<>
 bool
-KDTrapWeather::step ()
+Parameter<KDTrapWeather::Timeline>::decode (const String& raw) const
 {
-	Precipitation precip = Mission::get_precipitation ();
-	precip.frequency = transition.interpolate (start_freq, end_freq);
-	precip.speed = transition.interpolate (start_speed, end_speed);
-	precip.radius = transition.interpolate (start_radius, end_radius);
-	precip.opacity = transition.interpolate (start_opacity, end_opacity);
-	precip.brightness = transition.interpolate
-		(start_brightness, end_brightness);
-	precip.wind = transition.interpolate (start_wind, end_wind);
-	Mission::set_precipitation (precip);
+	if (raw.empty ())
+		return false;
+
+	value.clear ();
+	std::istringstream keyframes (raw);
+	String keyframe;
+	while (std::getline (keyframes, keyframe, '|'))
+	{
+		std::istringstream fields (keyframe);
+		unsigned long time;
+		KDTrapWeather::Keyframe each;
+		if (!(fields >> time >> each.freq >> each.speed >> each.radius
+				>> each.opacity >> each.brightness
+				>> each.wind.x >> each.wind.y >> each.wind.z))
+			throw std::runtime_error ("Invalid weather keyframe.");
+		each.time = time;
+
+		unsigned long last = value.empty () ? 0ul
+			: static_cast<unsigned long> (value.back ().time);
+		if (value.empty () ? time != 0ul : time <= last)
+			throw std::runtime_error ("Weather keyframes must "
+				"start at 0 and increase in time.");
+		value.push_back (each);
+	}
+
+	if (value.size () < 2u)
+		throw std::runtime_error ("A weather timeline needs at least "
+			"two keyframes.");
 	return true;
 }
 
+} // namespace Thief
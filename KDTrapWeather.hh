@@ -21,38 +21,80 @@
 #ifndef KDTRAPWEATHER_HH
 #define KDTRAPWEATHER_HH
 
-#include <Thief/Thief.hh>
-using namespace Thief;
+#include "KDEnvStepFilter.hh"
+#include "KDPackedState.hh"
+#include "KDWeatherStack.hh"
+#include <vector>
 
 class KDTrapWeather : public TrapTrigger
 {
 public:
 	KDTrapWeather (const String& name, const Object& host);
 
+	// One point of a weather cycle, at a time in ms from the cycle's start.
+	struct Keyframe
+	{
+		Time time;
+		float freq, speed, radius, opacity, brightness;
+		Vector wind;
+	};
+	typedef std::vector<Keyframe> Timeline;
+
 private:
+	virtual void initialize ();
+	virtual void deinitialize ();
+
 	virtual Message::Result on_trap (bool on, Message&);
 	bool step ();
+	void compose (Time now, unsigned long elapsed, bool last);
+
+	static const Time CYCLE_RESOLUTION;
+	void start_cycle (Time now);
+	Message::Result on_cycle (TimerMessage&);
 
 	Transition transition;
+	KDEnvStepFilter step_filter;
+	Precipitation last_precip;
 
 	Parameter<float> precip_freq_on, precip_freq_off;
-	Persistent<float> start_freq, end_freq;
-
 	Parameter<float> precip_speed_on, precip_speed_off;
-	Persistent<float> start_speed, end_speed;
-
 	Parameter<float> precip_radius_on, precip_radius_off;
-	Persistent<float> start_radius, end_radius;
-
 	Parameter<float> precip_opacity_on, precip_opacity_off;
-	Persistent<float> start_opacity, end_opacity;
-
 	Parameter<float> precip_brightness_on, precip_brightness_off;
-	Persistent<float> start_brightness, end_brightness;
-
 	Parameter<Vector> precip_wind_on, precip_wind_off;
-	Persistent<Vector> start_wind, end_wind;
+
+	// The aspects of the precipitation that the traps change.
+	struct Aspects
+	{
+		float freq, speed, radius, opacity, brightness;
+		Vector wind;
+
+		void read (const Precipitation&);
+		Precipitation apply (Precipitation) const;
+	};
+
+	// The start time of the transition or cycle, the precipitation it
+	// started from, and the transition's end.
+	struct State
+	{
+		Time start_time;
+		bool cycle;
+		Aspects base, end;
+	};
+	KDPackedState<State> state;
+
+	Parameter<Timeline> precip_timeline;
+	Persistent<int> cycles;
 };
 
+namespace Thief {
+
+template<> bool
+Parameter<KDTrapWeather::Timeline>::decode (const String& raw) const;
+template<> String
+Parameter<KDTrapWeather::Timeline>::encode () const; // undefined
+
+} // namespace Thief
+
 #endif // KDTRAPWEATHER_HH
 
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *  KDWeatherStack.cc
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "KDWeatherStack.hh"
+
+KDWeatherStack::Layers
+KDWeatherStack::layers;
+
+Precipitation
+KDWeatherStack::base;
+
+unsigned long
+KDWeatherStack::floor = 0ul;
+
+bool
+KDWeatherStack::composed = false;
+
+unsigned long
+KDWeatherStack::last_composed = 0ul;
+
+size_t
+KDWeatherStack::users = 0u;
+
+bool
+KDWeatherStack::update (const Object& owner, Time _started, float weight,
+	const Precipitation& value, const Precipitation& _base)
+{
+	unsigned long started = static_cast<unsigned long> (_started);
+	if (started < floor)
+		return false; // hidden by a later layer at full weight
+
+	auto layer = layers.begin ();
+	while (layer != layers.end () && (layer->owner != owner.number ||
+			layer->started != started))
+		++layer;
+
+	if (layer == layers.end ())
+	{
+		layer = layers.begin ();
+		while (layer != layers.end () && layer->started <= started)
+			++layer;
+
+		// The bottom layer's base is the stack's.
+		if (layer == layers.begin ())
+			base = _base;
+		layer = layers.insert (layer,
+			{ owner.number, started, weight, value });
+	}
+	else
+	{
+		layer->weight = weight;
+		layer->value = value;
+	}
+
+	// Drop any layers hidden by this one.
+	if (weight >= 1.0f)
+	{
+		layers.erase (layers.begin (), layer);
+		floor = started;
+	}
+
+	return true;
+}
+
+bool
+KDWeatherStack::compose (Time _now, Precipitation& result, bool force)
+{
+	unsigned long now = static_cast<unsigned long> (_now);
+	if (composed && now == last_composed && !force)
+		return false;
+	composed = true;
+	last_composed = now;
+
+	result = base;
+	for (auto& layer : layers)
+	{
+		const Precipitation& value = layer.value;
+		float weight = layer.weight;
+		result.frequency = interpolate
+			(result.frequency, value.frequency, weight);
+		result.speed = interpolate
+			(result.speed, value.speed, weight);
+		result.radius = interpolate
+			(result.radius, value.radius, weight);
+		result.opacity = interpolate
+			(result.opacity, value.opacity, weight);
+		result.brightness = interpolate
+			(result.brightness, value.brightness, weight);
+		result.wind = interpolate (result.wind, value.wind, weight);
+	}
+	return true;
+}
+
+size_t
+KDWeatherStack::count_blending ()
+{
+	size_t blending = 0u;
+	for (auto& layer : layers)
+		if (layer.weight < 1.0f)
+			++blending;
+	return blending;
+}
+
+void
+KDWeatherStack::attach ()
+{
+	++users;
+}
+
+void
+KDWeatherStack::detach ()
+{
+	if (users > 0u && --users == 0u)
+	{
+		layers.clear ();
+		floor = 0ul;
+		composed = false;
+	}
+}
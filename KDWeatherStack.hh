@@ -0,0 +1,79 @@
+/******************************************************************************
+ *  KDWeatherStack.hh
+ *
+ *  Copyright (C) 2013 Kevin Daughtridge <kevin@kdau.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef KDWEATHERSTACK_HH
+#define KDWEATHERSTACK_HH
+
+#include <Thief/Thief.hh>
+#include <vector>
+using namespace Thief;
+
+// Blends the precipitation contributed by all KDTrapWeather instances in the
+// module. Each transition or cycle has a layer, ordered by start time, whose
+// weight rises from zero to one over the transition. The precipitation is
+// composed from the bottom up, blending each layer over the result of those
+// below, starting from the base precipitation of the bottom layer: what was
+// in effect when that layer's trap started. A layer at full weight hides all
+// the layers below it, so they are dropped, and their owners should stop
+// stepping. A layer whose trap was retriggered, or whose transition has
+// finished, stays in place at its last weight until it is hidden.
+//
+// As with KDEnvScheduler, traps attach on initialize and detach on
+// deinitialize, and the stack is emptied when the last one detaches. The
+// layers and the base are rebuilt from the traps' saved start times and base
+// precipitation as their transitions resume after a game is loaded.
+class KDWeatherStack
+{
+public:
+	// Returns false if the owner's layer was hidden by a later one.
+	static bool update (const Object& owner, Time started, float weight,
+		const Precipitation& value, const Precipitation& base);
+
+	// Returns true if the composed precipitation should be written now:
+	// for the first composition at each time, or whenever forced.
+	static bool compose (Time now, Precipitation& result,
+		bool force = false);
+
+	static size_t count_blending ();
+
+	static void attach ();
+	static void detach ();
+
+private:
+	struct Layer
+	{
+		Object::Number owner;
+		unsigned long started;
+		float weight;
+		Precipitation value;
+	};
+
+	typedef std::vector<Layer> Layers;
+	static Layers layers;
+	static Precipitation base;
+
+	static unsigned long floor;
+	static bool composed;
+	static unsigned long last_composed;
+
+	static size_t users;
+};
+
+#endif // KDWEATHERSTACK_HH